@@ -0,0 +1,492 @@
+#include "PluginProcessor.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+//==============================================================================
+/**
+ * SimpleGainBatchRender runs SimpleGainProcessor over audio files offline,
+ * without a host.
+ *
+ * Usage:
+ *   SimpleGainBatchRender --output-dir=<dir> [--params=<file>] [--threads=<n>]
+ *                         [--block-size=<n>] [--suffix=<text>] <file or directory>...
+ *
+ * Directories are searched recursively for WAV, AIFF and FLAC files, and each
+ * output goes to the same subdirectory under --output-dir as its input had
+ * under the directory given. Outputs keep the input's name, format, sample
+ * rate and (where the format allows) bit depth.
+ *
+ * --params is either a JSON file or a state file saved by the plugin. The
+ * JSON form sets parameters in their displayed units or by choice name, and
+ * can automate them at given times:
+ *
+ *   { "gain": -6.0, "modrate": 4.0, "moddepth": 0.5, "modshape": "Triangle",
+ *     "automation": [ { "time": 2.5, "parameter": "gain", "value": -12.0 } ] }
+ *
+ * Oversampling can be set but not automated: its latency is trimmed once per
+ * file, so it has to stay the same from start to end.
+ *
+ * Each worker thread owns one processor and takes the next file from a shared
+ * index, largest files first.
+ */
+namespace
+{
+    //==============================================================================
+    struct AutomationPoint
+    {
+        double timeSeconds = 0.0;
+        juce::String parameterID;
+        juce::var value;
+    };
+
+    struct RenderJob
+    {
+        juce::File input;
+        juce::File output;
+    };
+
+    struct RenderSettings
+    {
+        juce::MemoryBlock state;
+        juce::NamedValueSet parameters;
+        std::vector<AutomationPoint> automation;
+        int blockSize = 8192;
+        juce::File outputDirectory;
+        juce::String suffix;
+    };
+
+    struct RenderTotals
+    {
+        std::atomic<int> numRendered { 0 };
+        std::atomic<int> numFailed { 0 };
+        std::atomic<juce::int64> numFrames { 0 };
+    };
+
+    //==============================================================================
+    // Job files written before the rate got its wider range name it by its old ID
+    juce::String getParameterID(const juce::String& name)
+    {
+        return name == "modfreq" ? SimpleGainProcessor::modFreqID : name;
+    }
+
+    // Sets a parameter from a number in its own units, or from a choice or display string
+    bool setParameter(juce::AudioProcessorValueTreeState& parameters, const juce::String& parameterID, const juce::var& value)
+    {
+        auto* param = parameters.getParameter(parameterID);
+
+        if (param == nullptr)
+            return false;
+
+        param->setValueNotifyingHost(value.isString() ? param->getValueForText(value.toString())
+                                                      : param->convertTo0to1((float) value));
+        return true;
+    }
+
+    juce::Result loadSettings(const juce::File& file, RenderSettings& settings)
+    {
+        if (! file.existsAsFile())
+            return juce::Result::fail("Can't find " + file.getFullPathName());
+
+        const auto json = juce::JSON::parse(file.loadFileAsString());
+
+        // Anything that isn't a JSON object is treated as a saved plugin state
+        if (! json.isObject())
+        {
+            if (! file.loadFileAsData(settings.state))
+                return juce::Result::fail("Can't read " + file.getFullPathName());
+
+            return juce::Result::ok();
+        }
+
+        SimpleGainProcessor validator;
+
+        for (auto& property : json.getDynamicObject()->getProperties())
+        {
+            if (property.name == juce::Identifier("automation"))
+                continue;
+
+            const auto parameterID = getParameterID(property.name.toString());
+
+            if (validator.getParameters().getParameter(parameterID) == nullptr)
+                return juce::Result::fail("Unknown parameter \"" + property.name.toString() + "\"");
+
+            settings.parameters.set(parameterID, property.value);
+        }
+
+        if (auto* points = json["automation"].getArray())
+        {
+            for (auto& point : *points)
+            {
+                AutomationPoint automationPoint { (double) point["time"], getParameterID(point["parameter"].toString()), point["value"] };
+
+                if (validator.getParameters().getParameter(automationPoint.parameterID) == nullptr)
+                    return juce::Result::fail("Unknown automated parameter \"" + automationPoint.parameterID + "\"");
+
+                if (automationPoint.parameterID == SimpleGainProcessor::oversamplingID)
+                    return juce::Result::fail("Oversampling can't be automated, as it changes the latency mid-file");
+
+                settings.automation.push_back(automationPoint);
+            }
+        }
+
+        std::stable_sort(settings.automation.begin(), settings.automation.end(),
+                         [](const AutomationPoint& a, const AutomationPoint& b) { return a.timeSeconds < b.timeSeconds; });
+
+        return juce::Result::ok();
+    }
+
+    //==============================================================================
+    class RenderWorker : public juce::Thread
+    {
+    public:
+        RenderWorker(int index, const RenderSettings& settingsToUse, const juce::Array<RenderJob>& jobsToRender,
+                     std::atomic<int>& nextFileIndex, RenderTotals& totalsToUpdate)
+            : juce::Thread("Render worker " + juce::String(index)),
+              settings(settingsToUse),
+              jobs(jobsToRender),
+              nextFile(nextFileIndex),
+              totals(totalsToUpdate)
+        {
+            // Processors are created and configured on the main thread
+            formatManager.registerBasicFormats();
+            processor.setNonRealtime(true);
+
+            if (! settings.state.isEmpty())
+                processor.setStateInformation(settings.state.getData(), (int) settings.state.getSize());
+
+            for (auto& parameter : settings.parameters)
+                setParameter(processor.getParameters(), parameter.name.toString(), parameter.value);
+
+            // Every file starts from these values, whatever the previous file's automation did
+            for (auto* param : getAllParameters())
+                initialValues.add(param->getValue());
+        }
+
+        void run() override
+        {
+            // Files are handed out one at a time, so fast workers simply take more of them
+            for (auto index = nextFile++; index < jobs.size() && ! threadShouldExit(); index = nextFile++)
+            {
+                const auto error = renderFile(jobs.getReference(index));
+
+                if (error.isNotEmpty())
+                {
+                    ++totals.numFailed;
+                    const juce::ScopedLock lock(getOutputLock());
+                    std::cerr << jobs.getReference(index).input.getFullPathName() << ": " << error << std::endl;
+                }
+                else
+                {
+                    ++totals.numRendered;
+                }
+            }
+        }
+
+        static juce::CriticalSection& getOutputLock()
+        {
+            static juce::CriticalSection lock;
+            return lock;
+        }
+
+    private:
+        //==============================================================================
+        // SimpleGainProcessor::getParameters() returns the value tree state, so ask the base class
+        const juce::Array<juce::AudioProcessorParameter*>& getAllParameters() const
+        {
+            return static_cast<const juce::AudioProcessor&>(processor).getParameters();
+        }
+
+        std::unique_ptr<juce::AudioFormatReader> createReader(const juce::File& file, juce::AudioFormat& format)
+        {
+            // WAV and AIFF can be read straight from a memory-mapped file
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader(format.createMemoryMappedReader(file));
+
+            if (mappedReader != nullptr && mappedReader->mapEntireFile())
+                return mappedReader;
+
+            return std::unique_ptr<juce::AudioFormatReader>(format.createReaderFor(file.createInputStream().release(), true));
+        }
+
+        juce::String renderFile(const RenderJob& job)
+        {
+            const auto& input = job.input;
+            const auto& output = job.output;
+            auto* format = formatManager.findFormatForFileExtension(input.getFileExtension());
+
+            if (format == nullptr)
+                return "unsupported file type";
+
+            auto reader = createReader(input, *format);
+
+            if (reader == nullptr)
+                return "can't read file";
+
+            const auto numChannels = (int) reader->numChannels;
+            const auto sampleRate = reader->sampleRate;
+
+            if (! prepareProcessor(numChannels, sampleRate))
+                return "unsupported channel count (" + juce::String(numChannels) + ")";
+
+            output.deleteFile();
+            auto stream = std::make_unique<juce::FileOutputStream>(output);
+
+            if (stream->failedToOpen())
+                return "can't create " + output.getFullPathName();
+
+            // Keep the input's bit depth when the format can write it
+            const auto bitDepths = format->getPossibleBitDepths();
+            const auto bitsPerSample = bitDepths.contains((int) reader->bitsPerSample) ? (int) reader->bitsPerSample
+                                                                                       : bitDepths.getLast();
+
+            std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                                    bitsPerSample, reader->metadataValues, 0));
+
+            if (writer == nullptr)
+                return "can't write " + format->getFormatName();
+
+            stream.release();
+
+            // The latency is trimmed from the start and rendered on at the end, along with any tail
+            const auto latency = (juce::int64) processor.getLatencySamples();
+            const auto tail = (juce::int64) std::ceil(processor.getTailLengthSeconds() * sampleRate);
+            const auto numFramesToRender = reader->lengthInSamples + latency + tail;
+            size_t nextPoint = 0;
+            juce::MidiBuffer midi;
+
+            for (juce::int64 position = 0; position < numFramesToRender;)
+            {
+                // Apply automation that is due, and stop the block at the next point
+                auto blockLength = (int) juce::jmin((juce::int64) settings.blockSize, numFramesToRender - position);
+
+                for (; nextPoint < settings.automation.size(); ++nextPoint)
+                {
+                    const auto& point = settings.automation[nextPoint];
+                    const auto pointPosition = (juce::int64) (point.timeSeconds * sampleRate);
+
+                    if (pointPosition > position)
+                    {
+                        blockLength = (int) juce::jmin((juce::int64) blockLength, pointPosition - position);
+                        break;
+                    }
+
+                    setParameter(processor.getParameters(), point.parameterID, point.value);
+                }
+
+                // Reads past the end of the file come back as silence
+                reader->read(&buffer, 0, blockLength, position, true, true);
+
+                juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), numChannels, 0, blockLength);
+                processor.processBlock(block, midi);
+
+                const auto skip = (int) juce::jlimit((juce::int64) 0, (juce::int64) blockLength, latency - position);
+
+                if (skip < blockLength && ! writer->writeFromAudioSampleBuffer(block, skip, blockLength - skip))
+                    return "write failed";
+
+                position += blockLength;
+            }
+
+            totals.numFrames += reader->lengthInSamples;
+            return {};
+        }
+
+        bool prepareProcessor(int numChannels, double sampleRate)
+        {
+            processor.releaseResources();
+
+            juce::AudioProcessor::BusesLayout layout;
+            layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+            layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+
+            if (! processor.setBusesLayout(layout))
+                return false;
+
+            auto& params = getAllParameters();
+
+            for (int i = 0; i < params.size(); ++i)
+                params[i]->setValueNotifyingHost(initialValues[i]);
+
+            // Preparing for every file also restarts the LFO and the smoothers
+            processor.setRateAndBufferSizeDetails(sampleRate, settings.blockSize);
+            processor.prepareToPlay(sampleRate, settings.blockSize);
+            buffer.setSize(numChannels, settings.blockSize, false, false, true);
+            return true;
+        }
+
+        //==============================================================================
+        const RenderSettings& settings;
+        const juce::Array<RenderJob>& jobs;
+        std::atomic<int>& nextFile;
+        RenderTotals& totals;
+
+        juce::AudioFormatManager formatManager;
+        SimpleGainProcessor processor;
+        juce::Array<float> initialValues;
+        juce::AudioBuffer<float> buffer;
+
+        JUCE_DECLARE_NON_COPYABLE(RenderWorker)
+    };
+
+    //==============================================================================
+    juce::File getOutputFile(const RenderSettings& settings, const juce::File& input, const juce::File& searchedDirectory)
+    {
+        // Keep the input's place below the directory it was found in, so equal names in different folders don't collide
+        const auto directory = searchedDirectory == juce::File() ? settings.outputDirectory
+                                                                 : settings.outputDirectory.getChildFile(input.getRelativePathFrom(searchedDirectory))
+                                                                                           .getParentDirectory();
+
+        return directory.getChildFile(input.getFileNameWithoutExtension() + settings.suffix + input.getFileExtension());
+    }
+
+    juce::Array<RenderJob> findRenderJobs(const juce::ArgumentList& args, const RenderSettings& settings)
+    {
+        constexpr auto wildcard = "*.wav;*.wave;*.aif;*.aiff;*.flac";
+        juce::Array<RenderJob> jobs;
+
+        for (auto& argument : args.arguments)
+        {
+            if (argument.isOption())
+                continue;
+
+            const auto file = argument.resolveAsFile();
+
+            if (file.isDirectory())
+            {
+                for (auto& input : file.findChildFiles(juce::File::findFiles, true, wildcard))
+                    jobs.add(RenderJob { input, getOutputFile(settings, input, file) });
+            }
+            else if (file.existsAsFile())
+            {
+                jobs.add(RenderJob { file, getOutputFile(settings, file, {}) });
+            }
+            else
+            {
+                std::cerr << "Skipping " << file.getFullPathName() << ": not found" << std::endl;
+            }
+        }
+
+        // Largest first, so one long file doesn't start last and leave the other workers idle
+        std::stable_sort(jobs.begin(), jobs.end(),
+                         [](const RenderJob& a, const RenderJob& b) { return a.input.getSize() > b.input.getSize(); });
+        return jobs;
+    }
+
+    // Workers delete and rewrite their outputs, so no two jobs may share one or write over an input
+    juce::Result checkOutputFiles(const juce::Array<RenderJob>& jobs)
+    {
+        std::map<juce::String, const RenderJob*> outputs;
+        std::set<juce::String> inputs;
+
+        for (auto& job : jobs)
+            inputs.insert(job.input.getFullPathName());
+
+        for (auto& job : jobs)
+        {
+            const auto path = job.output.getFullPathName();
+
+            if (inputs.count(path) > 0)
+                return juce::Result::fail(job.input.getFullPathName() + ": output would overwrite an input");
+
+            const auto inserted = outputs.emplace(path, &job);
+
+            if (! inserted.second)
+                return juce::Result::fail(inserted.first->second->input.getFullPathName() + " and " + job.input.getFullPathName()
+                                          + " would both be written to " + path);
+        }
+
+        for (auto& job : jobs)
+            if (! job.output.getParentDirectory().createDirectory())
+                return juce::Result::fail("Can't create " + job.output.getParentDirectory().getFullPathName());
+
+        return juce::Result::ok();
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    RenderSettings settings;
+
+    if (! args.containsOption("--output-dir"))
+    {
+        std::cerr << "Usage: " << args.executableName << " --output-dir=<dir> [--params=<file>] [--threads=<n>]"
+                  << " [--block-size=<n>] [--suffix=<text>] <file or directory>..." << std::endl;
+        return 1;
+    }
+
+    settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--output-dir"));
+    settings.suffix = args.getValueForOption("--suffix");
+
+    if (args.containsOption("--block-size"))
+        settings.blockSize = juce::jlimit(16, 1 << 16, args.getValueForOption("--block-size").getIntValue());
+
+    if (args.containsOption("--params"))
+    {
+        const auto result = loadSettings(juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--params")),
+                                         settings);
+
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+    }
+
+    if (! settings.outputDirectory.createDirectory())
+    {
+        std::cerr << "Can't create " << settings.outputDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    const auto jobs = findRenderJobs(args, settings);
+
+    if (jobs.isEmpty())
+    {
+        std::cerr << "No input files" << std::endl;
+        return 1;
+    }
+
+    const auto outputCheck = checkOutputFiles(jobs);
+
+    if (outputCheck.failed())
+    {
+        std::cerr << outputCheck.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    const auto numThreads = juce::jlimit(1, jobs.size(),
+                                         args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue()
+                                                                          : juce::SystemStats::getNumCpus());
+
+    std::atomic<int> nextFile { 0 };
+    RenderTotals totals;
+    juce::OwnedArray<RenderWorker> workers;
+
+    for (int i = 0; i < numThreads; ++i)
+        workers.add(new RenderWorker(i, settings, jobs, nextFile, totals));
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    for (auto* worker : workers)
+        worker->waitForThreadToExit(-1);
+
+    const auto seconds = juce::jmax(1.0e-9, (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001);
+
+    std::cout << "Rendered " << totals.numRendered.load() << " files (" << totals.numFailed.load() << " failed) with "
+              << numThreads << " threads in " << seconds << " s: "
+              << totals.numRendered.load() / seconds << " files/s, "
+              << (double) totals.numFrames.load() / seconds << " frames/s" << std::endl;
+
+    return totals.numFailed.load() > 0 ? 1 : 0;
+}
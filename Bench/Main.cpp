@@ -0,0 +1,1005 @@
+#include "MultiStreamEngine.h"
+#include "PluginProcessor.h"
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+/**
+ * SimpleGainBench drives SimpleGainProcessor directly, without a host, and
+ * reports the cost of processBlock across block sizes, channel layouts,
+ * sample rates and parameter states.
+ *
+ * Usage:
+ *   SimpleGainBench [--format=csv|jsonl] [--output=<file>] [--runs=<n>]
+ *                   [--precision=float,double] [--block-sizes=64,512] [--channels=1,2,16]
+ *                   [--rates=44100,48000] [--states=static,automated] [--metering=off,on]
+ *                   [--oversampling=off,2x,4x,8x] [--inputs=noise,sparse,silent]
+ *   SimpleGainBench --instances=1,100,1000 [--editors=off,on] [--format=csv|jsonl] [--output=<file>]
+ *   SimpleGainBench --state [--state-calls=<n>] [--format=csv|jsonl] [--output=<file>]
+ *   SimpleGainBench --presets [--preset-count=<n>] [--preset-calls=<n>] [--format=csv|jsonl] [--output=<file>]
+ *   SimpleGainBench --clipper [--clipper-calls=<n>] [--format=csv|jsonl] [--output=<file>]
+ *   SimpleGainBench --streams=16,256,1024 [--stream-threads=1,<cpus>] [--stream-calls=<n>]
+ *                   [--format=csv|jsonl] [--output=<file>]
+ *
+ * All timings are per sample frame (one sample on every channel). The
+ * --instances mode instead reports how long it takes to construct and prepare
+ * that many processors (and editors), and how much resident memory they add.
+ * The --state mode times getStateInformation/setStateInformation for the
+ * binary and legacy XML states, and exits with an error if a round trip fails.
+ * The --presets mode times bank loading and program switching, and --clipper
+ * compares the output stage against the plain gain kernel and std::tanh.
+ * --streams runs that many mono streams with their own gain and tremolo,
+ * through one processor each and through MultiStreamEngine, and reports the
+ * time per block and per stream sample.
+ *
+ * The gain kernel variant KernelDispatch picked for this CPU is printed at the
+ * start and recorded with every processing result; --clipper times each
+ * variant the CPU can run.
+ */
+namespace
+{
+    //==============================================================================
+    enum class ParameterState
+    {
+        unity,              // 0 dB, depth 0: passthrough kernel
+        staticGain,         // fixed gain, depth 0
+        staticModulated,    // fixed gain, depth 1
+        automated,          // gain automated every block, depth 0
+        automatedModulated, // gain and depth automated every block
+        audioRateModulated, // fixed gain, depth 1 at 1 kHz, oversampled when enabled
+        autoPan,            // fixed gain, depth 1, right channel 180 degrees behind the left
+        midSide             // fixed gain, depth 1 on mid, side 90 degrees behind and 3 dB up
+    };
+
+    const char* getStateName(ParameterState state)
+    {
+        switch (state)
+        {
+            case ParameterState::unity:              return "unity";
+            case ParameterState::staticGain:         return "static";
+            case ParameterState::staticModulated:    return "static-mod";
+            case ParameterState::automated:          return "automated";
+            case ParameterState::automatedModulated: return "automated-mod";
+            case ParameterState::audioRateModulated: return "audio-mod";
+            case ParameterState::autoPan:            return "auto-pan";
+            case ParameterState::midSide:            return "mid-side";
+        }
+
+        return "";
+    }
+
+    const ParameterState allStates[] = { ParameterState::unity,
+                                         ParameterState::staticGain,
+                                         ParameterState::staticModulated,
+                                         ParameterState::automated,
+                                         ParameterState::automatedModulated,
+                                         ParameterState::audioRateModulated,
+                                         ParameterState::autoPan,
+                                         ParameterState::midSide };
+
+    const char* const oversamplingNames[] = { "off", "2x", "4x", "8x" };
+
+    // Full-scale noise; 8192-sample bursts of it every 65536 samples, like a sparse
+    // arrangement; or digital silence throughout
+    const char* const inputNames[] = { "noise", "sparse", "silent" };
+
+    struct BenchCase
+    {
+        bool doublePrecision = false;
+        int blockSize = 512;
+        int numChannels = 2;
+        double sampleRate = 48000.0;
+        ParameterState state = ParameterState::staticGain;
+        bool metering = false;
+        int oversampling = 0;   // index into oversamplingNames
+        int input = 0;          // index into inputNames
+    };
+
+    struct BenchResult
+    {
+        double nsPerSample = 0.0;
+        double nsPerSampleStdDev = 0.0;
+        double nsPerSampleMin = 0.0;
+        double cyclesPerSample = -1.0;
+        double budgetPercent = 0.0;
+        double budgetPercentStdDev = 0.0;
+    };
+
+    //==============================================================================
+    void setParameter(SimpleGainProcessor& processor, const juce::String& parameterID, float value)
+    {
+        if (auto* param = processor.getParameters().getParameter(parameterID))
+            param->setValueNotifyingHost(param->convertTo0to1(value));
+    }
+
+    void applyStaticParameters(SimpleGainProcessor& processor, ParameterState state, int oversampling)
+    {
+        const auto isModulated = state == ParameterState::staticModulated
+                              || state == ParameterState::automatedModulated
+                              || state == ParameterState::audioRateModulated
+                              || state == ParameterState::autoPan
+                              || state == ParameterState::midSide;
+
+        setParameter(processor, SimpleGainProcessor::gainID, state == ParameterState::unity ? 0.0f : -6.0f);
+        setParameter(processor, SimpleGainProcessor::modFreqID, state == ParameterState::audioRateModulated ? 1000.0f : 5.0f);
+        setParameter(processor, SimpleGainProcessor::modDepthID, isModulated ? 1.0f : 0.0f);
+        setParameter(processor, SimpleGainProcessor::oversamplingID, (float) oversampling);
+
+        // Stereo layouts leave the shared envelope for these two; other layouts ignore them
+        setParameter(processor, SimpleGainProcessor::stereoModeID, state == ParameterState::midSide ? 1.0f : 0.0f);
+        setParameter(processor, SimpleGainProcessor::stereoPhaseID, state == ParameterState::autoPan ? 180.0f
+                                                                  : state == ParameterState::midSide ? 90.0f : 0.0f);
+        setParameter(processor, SimpleGainProcessor::sideGainID, state == ParameterState::midSide ? 3.0f : 0.0f);
+    }
+
+    // Called before every block for the automated states
+    void applyAutomation(SimpleGainProcessor& processor, ParameterState state, int blockIndex)
+    {
+        if (state != ParameterState::automated && state != ParameterState::automatedModulated)
+            return;
+
+        const auto odd = (blockIndex & 1) != 0;
+        setParameter(processor, SimpleGainProcessor::gainID, odd ? -3.0f : -12.0f);
+
+        if (state == ParameterState::automatedModulated)
+            setParameter(processor, SimpleGainProcessor::modDepthID, odd ? 1.0f : 0.5f);
+    }
+
+    juce::AudioProcessor::BusesLayout makeLayout(int numChannels)
+    {
+        juce::AudioProcessor::BusesLayout layout;
+
+        // Use the immersive layouts we actually run on for the wide buses
+        const auto set = numChannels == 12 ? juce::AudioChannelSet::create7point1point4()
+                       : numChannels == 16 ? juce::AudioChannelSet::ambisonic(3)
+                                           : juce::AudioChannelSet::canonicalChannelSet(numChannels);
+        layout.inputBuses.add(set);
+        layout.outputBuses.add(set);
+        return layout;
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    bool runCase(const BenchCase& benchCase, int numRuns, BenchResult& result)
+    {
+        SimpleGainProcessor processor;
+
+        if (! processor.setBusesLayout(makeLayout(benchCase.numChannels)))
+            return false;
+
+        processor.setProcessingPrecision(std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                             : juce::AudioProcessor::singlePrecision);
+        applyStaticParameters(processor, benchCase.state, benchCase.oversampling);
+        processor.setMeteringEnabled(benchCase.metering);
+        processor.setRateAndBufferSizeDetails(benchCase.sampleRate, benchCase.blockSize);
+        processor.prepareToPlay(benchCase.sampleRate, benchCase.blockSize);
+
+        // Each run processes a fresh copy of the source "tape" so the signal never decays to silence
+        const auto numBlocks = juce::jmax(16, (1 << 16) / benchCase.blockSize);
+        const auto numFrames = numBlocks * benchCase.blockSize;
+
+        juce::AudioBuffer<SampleType> source(benchCase.numChannels, numFrames);
+        juce::AudioBuffer<SampleType> tape(benchCase.numChannels, numFrames);
+        juce::Random random(0x5147);
+
+        for (int channel = 0; channel < source.getNumChannels(); ++channel)
+        {
+            for (int sample = 0; sample < numFrames; ++sample)
+            {
+                const auto isAudible = benchCase.input == 0 || (benchCase.input == 1 && (sample & 0xffff) < 8192);
+                source.setSample(channel, sample, isAudible ? (SampleType) (random.nextFloat() * 2.0f - 1.0f) : (SampleType) 0);
+            }
+        }
+
+        juce::MidiBuffer midi;
+        juce::Array<double> nsPerSample;
+        double totalCycles = 0.0;
+        int blockIndex = 0;
+        constexpr int numWarmupRuns = 2;
+
+        for (int run = 0; run < numWarmupRuns + numRuns; ++run)
+        {
+            tape.makeCopyOf(source, true);
+
+            const auto startCycles = PerformanceMonitor::readCycleCounter();
+            const auto startTime = std::chrono::steady_clock::now();
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                juce::AudioBuffer<SampleType> view(tape.getArrayOfWritePointers(), benchCase.numChannels,
+                                              block * benchCase.blockSize, benchCase.blockSize);
+                applyAutomation(processor, benchCase.state, blockIndex++);
+                processor.processBlock(view, midi);
+            }
+
+            const auto endTime = std::chrono::steady_clock::now();
+            const auto endCycles = PerformanceMonitor::readCycleCounter();
+
+            if (run < numWarmupRuns)
+                continue;
+
+            const auto ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+            nsPerSample.add(ns / numFrames);
+            totalCycles += (double) (endCycles - startCycles);
+        }
+
+        processor.releaseResources();
+
+        double sum = 0.0;
+
+        result.nsPerSampleMin = nsPerSample.getFirst();
+
+        for (auto value : nsPerSample)
+        {
+            sum += value;
+            result.nsPerSampleMin = juce::jmin(result.nsPerSampleMin, value);
+        }
+
+        result.nsPerSample = sum / numRuns;
+
+        double variance = 0.0;
+
+        for (auto value : nsPerSample)
+            variance += (value - result.nsPerSample) * (value - result.nsPerSample);
+
+        result.nsPerSampleStdDev = std::sqrt(variance / numRuns);
+
+        if (PerformanceMonitor::hasCycleCounter)
+            result.cyclesPerSample = totalCycles / ((double) numFrames * numRuns);
+
+        // One sample frame must be produced every 1e9 / sampleRate nanoseconds
+        const auto budgetNsPerSample = 1.0e9 / benchCase.sampleRate;
+        result.budgetPercent = 100.0 * result.nsPerSample / budgetNsPerSample;
+        result.budgetPercentStdDev = 100.0 * result.nsPerSampleStdDev / budgetNsPerSample;
+
+        return true;
+    }
+
+    //==============================================================================
+    juce::String formatCsvHeader()
+    {
+        return "precision,block_size,channels,sample_rate,state,metering,oversampling,input,kernels,ns_per_sample,ns_per_sample_stddev,ns_per_sample_min,"
+               "cycles_per_sample,rt_budget_percent,rt_budget_percent_stddev";
+    }
+
+    juce::String formatResult(const BenchCase& c, const BenchResult& r, bool asJson)
+    {
+        auto number = [](double value) { return juce::String(value, 4); };
+        const auto kernels = juce::String(KernelDispatch::getName(KernelDispatch::getKernels().variant));
+
+        if (asJson)
+        {
+            return "{\"precision\":\"" + juce::String(c.doublePrecision ? "double" : "float") + "\""
+                 + ",\"block_size\":" + juce::String(c.blockSize)
+                 + ",\"channels\":" + juce::String(c.numChannels)
+                 + ",\"sample_rate\":" + juce::String((int) c.sampleRate)
+                 + ",\"state\":\"" + getStateName(c.state) + "\""
+                 + ",\"metering\":" + (c.metering ? "true" : "false")
+                 + ",\"oversampling\":\"" + oversamplingNames[c.oversampling] + "\""
+                 + ",\"input\":\"" + inputNames[c.input] + "\""
+                 + ",\"kernels\":\"" + kernels + "\""
+                 + ",\"ns_per_sample\":" + number(r.nsPerSample)
+                 + ",\"ns_per_sample_stddev\":" + number(r.nsPerSampleStdDev)
+                 + ",\"ns_per_sample_min\":" + number(r.nsPerSampleMin)
+                 + ",\"cycles_per_sample\":" + number(r.cyclesPerSample)
+                 + ",\"rt_budget_percent\":" + number(r.budgetPercent)
+                 + ",\"rt_budget_percent_stddev\":" + number(r.budgetPercentStdDev) + "}";
+        }
+
+        return juce::String(c.doublePrecision ? "double," : "float,")
+             + juce::String(c.blockSize) + "," + juce::String(c.numChannels) + "," + juce::String((int) c.sampleRate) + ","
+             + getStateName(c.state) + "," + (c.metering ? "on," : "off,") + oversamplingNames[c.oversampling] + ","
+             + inputNames[c.input] + "," + kernels + ","
+             + number(r.nsPerSample) + "," + number(r.nsPerSampleStdDev) + ","
+             + number(r.nsPerSampleMin) + "," + number(r.cyclesPerSample) + ","
+             + number(r.budgetPercent) + "," + number(r.budgetPercentStdDev);
+    }
+
+    //==============================================================================
+    template <typename Type>
+    juce::Array<Type> parseList(const juce::ArgumentList& args, const juce::String& option, juce::Array<Type> defaults)
+    {
+        if (! args.containsOption(option))
+            return defaults;
+
+        juce::Array<Type> values;
+
+        for (auto& token : juce::StringArray::fromTokens(args.getValueForOption(option), ",", {}))
+            values.add((Type) token.getDoubleValue());
+
+        return values;
+    }
+
+    juce::Array<ParameterState> parseStates(const juce::ArgumentList& args)
+    {
+        juce::Array<ParameterState> states;
+
+        if (! args.containsOption("--states"))
+        {
+            states.addArray(allStates, juce::numElementsInArray(allStates));
+            return states;
+        }
+
+        for (auto& token : juce::StringArray::fromTokens(args.getValueForOption("--states"), ",", {}))
+            for (auto state : allStates)
+                if (token == getStateName(state))
+                    states.add(state);
+
+        return states;
+    }
+
+    juce::Array<int> parseOversampling(const juce::ArgumentList& args)
+    {
+        juce::Array<int> factors;
+        const auto tokens = args.containsOption("--oversampling")
+                              ? juce::StringArray::fromTokens(args.getValueForOption("--oversampling"), ",", {})
+                              : juce::StringArray(oversamplingNames, juce::numElementsInArray(oversamplingNames));
+
+        for (auto& token : tokens)
+            for (int index = 0; index < juce::numElementsInArray(oversamplingNames); ++index)
+                if (token == oversamplingNames[index])
+                    factors.add(index);
+
+        return factors;
+    }
+
+    // Noise only unless asked, to keep the default sweep the same size
+    juce::Array<int> parseInputs(const juce::ArgumentList& args)
+    {
+        juce::Array<int> inputs;
+
+        for (auto& token : juce::StringArray::fromTokens(args.getValueForOption("--inputs"), ",", {}))
+            for (int index = 0; index < juce::numElementsInArray(inputNames); ++index)
+                if (token == inputNames[index])
+                    inputs.add(index);
+
+        if (inputs.isEmpty())
+            inputs.add(0);
+
+        return inputs;
+    }
+
+    //==============================================================================
+    // Resident set size in bytes, or -1 where it can't be read
+    juce::int64 getResidentBytes()
+    {
+       #if JUCE_LINUX
+        std::ifstream statm("/proc/self/statm");
+        long long totalPages = 0, residentPages = 0;
+
+        if (statm >> totalPages >> residentPages)
+            return (juce::int64) residentPages * (juce::int64) sysconf(_SC_PAGESIZE);
+       #endif
+
+        return -1;
+    }
+
+    struct InstanceResult
+    {
+        int numInstances = 0;
+        bool withEditors = false;
+        double constructionMs = 0.0;
+        juce::int64 residentBytes = -1;     // growth while the instances exist
+    };
+
+    InstanceResult runInstanceCase(int numInstances, bool withEditors)
+    {
+        InstanceResult result { numInstances, withEditors };
+        std::vector<std::unique_ptr<SimpleGainProcessor>> processors;
+        std::vector<std::unique_ptr<juce::AudioProcessorEditor>> editors;
+        processors.reserve((size_t) numInstances);
+        editors.reserve((size_t) numInstances);
+
+        const auto residentBefore = getResidentBytes();
+        const auto startTime = std::chrono::steady_clock::now();
+
+        // What a host does when it loads a session: construct, prepare and maybe open the editor
+        for (int i = 0; i < numInstances; ++i)
+        {
+            processors.push_back(std::make_unique<SimpleGainProcessor>());
+            processors.back()->setRateAndBufferSizeDetails(48000.0, 512);
+            processors.back()->prepareToPlay(48000.0, 512);
+
+            if (withEditors)
+                editors.emplace_back(processors.back()->createEditor());
+        }
+
+        const auto endTime = std::chrono::steady_clock::now();
+        const auto residentAfter = getResidentBytes();
+
+        result.constructionMs = (double) std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() * 0.001;
+
+        if (residentBefore >= 0 && residentAfter >= 0)
+            result.residentBytes = residentAfter - residentBefore;
+
+        // Editors must go before their processors
+        editors.clear();
+        return result;
+    }
+
+    juce::String formatInstanceCsvHeader()
+    {
+        return "instances,editors,construction_ms,us_per_instance,rss_kb,rss_kb_per_instance";
+    }
+
+    juce::String formatInstanceResult(const InstanceResult& r, bool asJson)
+    {
+        auto number = [](double value) { return juce::String(value, 4); };
+        const auto usPerInstance = 1000.0 * r.constructionMs / juce::jmax(1, r.numInstances);
+        const auto residentKb = r.residentBytes >= 0 ? (double) r.residentBytes / 1024.0 : -1.0;
+        const auto residentKbPerInstance = r.residentBytes >= 0 ? residentKb / juce::jmax(1, r.numInstances) : -1.0;
+
+        if (asJson)
+        {
+            return "{\"instances\":" + juce::String(r.numInstances)
+                 + ",\"editors\":" + (r.withEditors ? "true" : "false")
+                 + ",\"construction_ms\":" + number(r.constructionMs)
+                 + ",\"us_per_instance\":" + number(usPerInstance)
+                 + ",\"rss_kb\":" + number(residentKb)
+                 + ",\"rss_kb_per_instance\":" + number(residentKbPerInstance) + "}";
+        }
+
+        return juce::String(r.numInstances) + "," + (r.withEditors ? "on," : "off,") + number(r.constructionMs) + ","
+             + number(usPerInstance) + "," + number(residentKb) + "," + number(residentKbPerInstance);
+    }
+
+    // Each case runs in a fresh process, so memory freed by an earlier case can't hide growth
+    void runInstanceSweep(const juce::ArgumentList& args, bool asJson, juce::StringArray& lines)
+    {
+        const auto instanceCounts = parseList<int>(args, "--instances", { 1, 100, 1000 });
+        const auto editorModes = args.containsOption("--editors")
+                                   ? juce::StringArray::fromTokens(args.getValueForOption("--editors"), ",", {})
+                                   : juce::StringArray { "off", "on" };
+        const auto executable = juce::File::getSpecialLocation(juce::File::currentExecutableFile);
+
+        if (! asJson)
+            lines.add(formatInstanceCsvHeader());
+
+        for (auto numInstances : instanceCounts)
+        {
+            for (auto& editors : editorModes)
+            {
+                juce::ChildProcess child;
+                juce::StringArray command { executable.getFullPathName(),
+                                            "--instance-case=" + juce::String(numInstances),
+                                            "--editors=" + editors,
+                                            asJson ? "--format=jsonl" : "--format=csv" };
+
+                const auto line = child.start(command, juce::ChildProcess::wantStdOut)
+                                    ? child.readAllProcessOutput().trim()
+                                    : juce::String();
+
+                if (line.isEmpty())
+                {
+                    std::cerr << "Instance case failed: " << numInstances << " instances" << std::endl;
+                    continue;
+                }
+
+                std::cerr << line << std::endl;
+                lines.add(line);
+            }
+        }
+    }
+
+    //==============================================================================
+    // Parameter values that differ from every default, so a round trip can't pass by accident
+    void applyRecallParameters(SimpleGainProcessor& processor)
+    {
+        setParameter(processor, SimpleGainProcessor::gainID, -7.3f);
+        setParameter(processor, SimpleGainProcessor::modFreqID, 123.45f);
+        setParameter(processor, SimpleGainProcessor::modDepthID, 0.37f);
+        setParameter(processor, SimpleGainProcessor::modShapeID, 3.0f);
+        setParameter(processor, SimpleGainProcessor::oversamplingID, 2.0f);
+    }
+
+    // The format getStateInformation wrote before the binary state
+    juce::MemoryBlock createXmlState(SimpleGainProcessor& processor)
+    {
+        juce::MemoryBlock block;
+        std::unique_ptr<juce::XmlElement> xml(processor.getParameters().copyState().createXml());
+        juce::AudioProcessor::copyXmlToBinary(*xml, block);
+        return block;
+    }
+
+    bool parametersMatch(SimpleGainProcessor& a, SimpleGainProcessor& b)
+    {
+        for (auto* id : { &SimpleGainProcessor::gainID, &SimpleGainProcessor::modFreqID, &SimpleGainProcessor::modDepthID,
+                          &SimpleGainProcessor::modShapeID, &SimpleGainProcessor::oversamplingID })
+        {
+            auto* paramA = a.getParameters().getParameter(*id);
+            auto* paramB = b.getParameters().getParameter(*id);
+
+            if (std::abs(paramA->getValue() - paramB->getValue()) > 1.0e-6f)
+            {
+                std::cerr << "Round trip mismatch: " << *id << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template <typename Function>
+    double timeCallsMicroseconds(int numCalls, Function&& function)
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < numCalls; ++i)
+            function(i);
+
+        const auto elapsed = std::chrono::steady_clock::now() - startTime;
+        return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() * 0.001 / numCalls;
+    }
+
+    juce::String formatStateResult(const juce::String& format, const juce::String& operation, size_t numBytes,
+                                   double usPerCall, bool roundTripOk, bool asJson)
+    {
+        const auto callsPerSecond = usPerCall > 0.0 ? 1.0e6 / usPerCall : 0.0;
+
+        if (asJson)
+        {
+            return "{\"format\":\"" + format + "\",\"operation\":\"" + operation
+                 + "\",\"bytes\":" + juce::String((juce::int64) numBytes)
+                 + ",\"us_per_call\":" + juce::String(usPerCall, 4)
+                 + ",\"calls_per_second\":" + juce::String(callsPerSecond, 1)
+                 + ",\"round_trip\":" + (roundTripOk ? "true" : "false") + "}";
+        }
+
+        return format + "," + operation + "," + juce::String((juce::int64) numBytes) + "," + juce::String(usPerCall, 4)
+             + "," + juce::String(callsPerSecond, 1) + "," + (roundTripOk ? "ok" : "failed");
+    }
+
+    // Save/load throughput of the binary state against the older XML state, plus a
+    // round trip through each. Returns false if any round trip loses a value.
+    bool runStateSweep(const juce::ArgumentList& args, bool asJson, juce::StringArray& lines)
+    {
+        const auto numCalls = juce::jmax(1, args.containsOption("--state-calls") ? args.getValueForOption("--state-calls").getIntValue() : 20000);
+
+        SimpleGainProcessor source, defaults, destination;
+        applyRecallParameters(source);
+
+        juce::MemoryBlock binaryState, defaultBinaryState;
+        source.getStateInformation(binaryState);
+        defaults.getStateInformation(defaultBinaryState);
+
+        const auto xmlState = createXmlState(source);
+        const auto defaultXmlState = createXmlState(defaults);
+
+        // Round trips, including loading an XML state saved by an older version
+        destination.setStateInformation(binaryState.getData(), (int) binaryState.getSize());
+        const auto binaryRoundTrip = parametersMatch(source, destination);
+
+        destination.setStateInformation(defaultBinaryState.getData(), (int) defaultBinaryState.getSize());
+        destination.setStateInformation(xmlState.getData(), (int) xmlState.getSize());
+        const auto xmlRoundTrip = parametersMatch(source, destination);
+
+        // Hosts hand over a fresh block for every save
+        const auto binarySave = timeCallsMicroseconds(numCalls, [&](int)
+        {
+            juce::MemoryBlock block;
+            source.getStateInformation(block);
+        });
+
+        const auto xmlSave = timeCallsMicroseconds(numCalls, [&](int)
+        {
+            auto block = createXmlState(source);
+            juce::ignoreUnused(block);
+        });
+
+        // Alternate between two states so every load changes every parameter
+        const auto binaryLoad = timeCallsMicroseconds(numCalls, [&](int i)
+        {
+            auto& block = (i & 1) == 0 ? binaryState : defaultBinaryState;
+            destination.setStateInformation(block.getData(), (int) block.getSize());
+        });
+
+        const auto xmlLoad = timeCallsMicroseconds(numCalls, [&](int i)
+        {
+            auto& block = (i & 1) == 0 ? xmlState : defaultXmlState;
+            destination.setStateInformation(block.getData(), (int) block.getSize());
+        });
+
+        if (! asJson)
+            lines.add("format,operation,bytes,us_per_call,calls_per_second,round_trip");
+
+        lines.add(formatStateResult("binary", "save", binaryState.getSize(), binarySave, binaryRoundTrip, asJson));
+        lines.add(formatStateResult("binary", "load", binaryState.getSize(), binaryLoad, binaryRoundTrip, asJson));
+        lines.add(formatStateResult("xml", "save", xmlState.getSize(), xmlSave, xmlRoundTrip, asJson));
+        lines.add(formatStateResult("xml", "load", xmlState.getSize(), xmlLoad, xmlRoundTrip, asJson));
+
+        for (auto& line : lines)
+            std::cerr << line << std::endl;
+
+        return binaryRoundTrip && xmlRoundTrip;
+    }
+
+    //==============================================================================
+    // Program switching: loading a bank file, setCurrentProgram on the calling thread, and the
+    // extra audio-thread cost of a block that picks up a switch
+    void runPresetSweep(const juce::ArgumentList& args, bool asJson, juce::StringArray& lines)
+    {
+        const auto numCalls = juce::jmax(1, args.containsOption("--preset-calls") ? args.getValueForOption("--preset-calls").getIntValue() : 20000);
+        const auto numPresets = juce::jlimit(1, 0xffff, args.containsOption("--preset-count") ? args.getValueForOption("--preset-count").getIntValue() : 128);
+        constexpr int blockSize = 64;
+
+        // A bank of distinct presets, written and mapped back in like a user's bank file
+        std::vector<PresetBank::Preset> presets;
+        const auto builtIn = PresetBank::getBuiltInPresets();
+
+        for (int i = 0; i < numPresets; ++i)
+        {
+            auto preset = builtIn[(size_t) i % builtIn.size()];
+            preset.name << " " << (i + 1);
+            preset.values[0] -= (float) (i % 24);
+            presets.push_back(preset);
+        }
+
+        juce::TemporaryFile bankFile(".sgbank");
+
+        if (! PresetBank::writeToFile(bankFile.getFile(), presets))
+        {
+            std::cerr << "Could not write " << bankFile.getFile().getFullPathName() << std::endl;
+            return;
+        }
+
+        const auto bankLoad = timeCallsMicroseconds(juce::jmax(1, numCalls / 100), [&](int)
+        {
+            PresetBank bank(bankFile.getFile());
+            juce::ignoreUnused(bank);
+        });
+
+        SimpleGainProcessor processor;
+        processor.setRateAndBufferSizeDetails(48000.0, blockSize);
+        processor.prepareToPlay(48000.0, blockSize);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        auto fillBuffer = [&] { for (int ch = 0; ch < 2; ++ch) juce::FloatVectorOperations::fill(buffer.getWritePointer(ch), 0.25f, blockSize); };
+
+        const auto numPrograms = processor.getNumPrograms();
+
+        // The switch alone; the occasional block keeps the event queue drained
+        const auto switchCall = timeCallsMicroseconds(numCalls, [&](int i)
+        {
+            processor.setCurrentProgram(i % numPrograms);
+
+            if ((i & 63) == 63)
+                processor.processBlock(buffer, midi);
+        });
+
+        // A host stepping through programs once per block
+        const auto blockWithSwitch = timeCallsMicroseconds(numCalls, [&](int i)
+        {
+            processor.setCurrentProgram(i % numPrograms);
+            fillBuffer();
+            processor.processBlock(buffer, midi);
+        });
+
+        const auto blockWithoutSwitch = timeCallsMicroseconds(numCalls, [&](int)
+        {
+            fillBuffer();
+            processor.processBlock(buffer, midi);
+        });
+
+        auto format = [asJson](const juce::String& operation, double usPerCall)
+        {
+            if (asJson)
+                return "{\"operation\":\"" + operation + "\",\"us_per_call\":" + juce::String(usPerCall, 4) + "}";
+
+            return operation + "," + juce::String(usPerCall, 4);
+        };
+
+        if (! asJson)
+            lines.add("operation,us_per_call");
+
+        lines.add(format("bank_load_" + juce::String(numPresets), bankLoad));
+        lines.add(format("set_current_program", switchCall));
+        lines.add(format("block_with_switch", blockWithSwitch));
+        lines.add(format("block_without_switch", blockWithoutSwitch));
+
+        for (auto& line : lines)
+            std::cerr << line << std::endl;
+    }
+
+    //==============================================================================
+    // The output stage on its own: the gain kernel without it, fused with the soft and hard
+    // clippers, and followed by a separate std::tanh pass for comparison. Every variant
+    // starts by copying in fresh input, which the "copy" row measures on its own.
+    template <typename SampleType>
+    void runClipperCase(const KernelDispatch::KernelTable& kernels, int numCalls, bool asJson, juce::StringArray& lines)
+    {
+        constexpr int numChannels = 2;
+        constexpr int blockSize = 512;
+        const auto gain = (SampleType) 4;
+
+        juce::AudioBuffer<SampleType> source(numChannels, blockSize), buffer(numChannels, blockSize);
+        juce::Random random(0x5147);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int sample = 0; sample < blockSize; ++sample)
+                source.setSample(channel, sample, (SampleType) (random.nextFloat() * 2.0f - 1.0f));
+
+        GainKernels::OutputStage softStage { GainKernels::OutputStage::Mode::softClip, 0.89f };
+        GainKernels::OutputStage hardStage { GainKernels::OutputStage::Mode::hardClip, 0.89f };
+        auto* channels = buffer.getArrayOfWritePointers();
+        const auto precision = juce::String(std::is_same_v<SampleType, double> ? "double" : "float");
+        const auto kernelName = juce::String(KernelDispatch::getName(kernels.variant));
+        auto applyGain = kernels.get<SampleType>().applyGain;
+
+        auto run = [&](const juce::String& variant, auto&& process)
+        {
+            const auto usPerCall = timeCallsMicroseconds(numCalls, [&](int)
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                    juce::FloatVectorOperations::copy(channels[channel], source.getReadPointer(channel), blockSize);
+
+                process();
+            });
+
+            const auto nsPerSample = usPerCall * 1000.0 / blockSize;
+
+            if (asJson)
+                lines.add("{\"precision\":\"" + precision + "\",\"kernels\":\"" + kernelName + "\",\"variant\":\"" + variant
+                          + "\",\"ns_per_sample\":" + juce::String(nsPerSample, 4) + "}");
+            else
+                lines.add(precision + "," + kernelName + "," + variant + "," + juce::String(nsPerSample, 4));
+        };
+
+        run("copy", [] {});
+        run("gain", [&] { applyGain(channels, numChannels, 0, gain, blockSize, nullptr, nullptr, nullptr); });
+        run("gain+soft", [&] { applyGain(channels, numChannels, 0, gain, blockSize, nullptr, nullptr, &softStage); });
+        run("gain+hard", [&] { applyGain(channels, numChannels, 0, gain, blockSize, nullptr, nullptr, &hardStage); });
+        run("gain+std::tanh", [&]
+        {
+            applyGain(channels, numChannels, 0, gain, blockSize, nullptr, nullptr, nullptr);
+            const auto ceiling = (SampleType) softStage.ceiling;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int sample = 0; sample < blockSize; ++sample)
+                    channels[channel][sample] = ceiling * std::tanh(channels[channel][sample] / ceiling);
+        });
+    }
+
+    void runClipperSweep(const juce::ArgumentList& args, bool asJson, juce::StringArray& lines)
+    {
+        const auto numCalls = juce::jmax(1, args.containsOption("--clipper-calls") ? args.getValueForOption("--clipper-calls").getIntValue() : 20000);
+
+        if (! asJson)
+            lines.add("precision,kernels,variant,ns_per_sample");
+
+        for (int i = 0; i < (int) KernelDispatch::Variant::numVariants; ++i)
+        {
+            if (auto* kernels = KernelDispatch::getKernels((KernelDispatch::Variant) i))
+            {
+                runClipperCase<float>(*kernels, numCalls, asJson, lines);
+                runClipperCase<double>(*kernels, numCalls, asJson, lines);
+            }
+        }
+
+        for (auto& line : lines)
+            std::cerr << line << std::endl;
+    }
+
+    //==============================================================================
+    // Many mono streams, each with its own gain and tremolo: one SimpleGainProcessor per stream
+    // against MultiStreamEngine on each of the --stream-threads thread counts. Every call
+    // refills the streams first, so neither side runs into denormals.
+    void runStreamSweep(const juce::ArgumentList& args, bool asJson, juce::StringArray& lines)
+    {
+        const auto streamCounts = parseList<int>(args, "--streams", { 16, 256, 1024 });
+        const auto threadCounts = parseList<int>(args, "--stream-threads", { 1, juce::SystemStats::getNumCpus() });
+        const auto numCalls = juce::jmax(1, args.containsOption("--stream-calls") ? args.getValueForOption("--stream-calls").getIntValue() : 200);
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+
+        auto gainOf = [](int stream)      { return -0.05f * (float) (stream % 240); };
+        auto depthOf = [](int stream)     { return 0.25f + 0.25f * (float) (stream % 4); };
+        auto frequencyOf = [](int stream) { return 0.5f + 0.01f * (float) (stream % 1000); };
+
+        auto format = [asJson](const juce::String& engine, int numStreams, int numThreads, double usPerCall)
+        {
+            const auto nsPerStreamSample = usPerCall * 1000.0 / ((double) numStreams * blockSize);
+
+            if (asJson)
+                return "{\"engine\":\"" + engine + "\",\"streams\":" + juce::String(numStreams)
+                     + ",\"threads\":" + juce::String(numThreads)
+                     + ",\"ns_per_stream_sample\":" + juce::String(nsPerStreamSample, 4)
+                     + ",\"us_per_block\":" + juce::String(usPerCall, 4) + "}";
+
+            return engine + "," + juce::String(numStreams) + "," + juce::String(numThreads) + ","
+                 + juce::String(nsPerStreamSample, 4) + "," + juce::String(usPerCall, 4);
+        };
+
+        auto report = [&lines](const juce::String& line)
+        {
+            std::cerr << line << std::endl;
+            lines.add(line);
+        };
+
+        if (! asJson)
+            lines.add("engine,streams,threads,ns_per_stream_sample,us_per_block");
+
+        for (auto numStreams : streamCounts)
+        {
+            juce::AudioBuffer<float> buffer(juce::jmax(1, numStreams), blockSize);
+            auto fillBuffer = [&] { for (int ch = 0; ch < buffer.getNumChannels(); ++ch) juce::FloatVectorOperations::fill(buffer.getWritePointer(ch), 0.25f, blockSize); };
+
+            {
+                std::vector<std::unique_ptr<SimpleGainProcessor>> processors;
+                juce::MidiBuffer midi;
+
+                for (int stream = 0; stream < numStreams; ++stream)
+                {
+                    auto processor = std::make_unique<SimpleGainProcessor>();
+
+                    if (! processor->setBusesLayout(makeLayout(1)))
+                        break;
+
+                    setParameter(*processor, SimpleGainProcessor::gainID, gainOf(stream));
+                    setParameter(*processor, SimpleGainProcessor::modDepthID, depthOf(stream));
+                    setParameter(*processor, SimpleGainProcessor::modFreqID, frequencyOf(stream));
+                    processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+                    processor->prepareToPlay(sampleRate, blockSize);
+                    processors.push_back(std::move(processor));
+                }
+
+                const auto usPerCall = timeCallsMicroseconds(numCalls, [&](int)
+                {
+                    fillBuffer();
+
+                    for (size_t stream = 0; stream < processors.size(); ++stream)
+                    {
+                        juce::AudioBuffer<float> view(buffer.getArrayOfWritePointers() + stream, 1, blockSize);
+                        processors[stream]->processBlock(view, midi);
+                    }
+                });
+
+                report(format("processors", numStreams, 1, usPerCall));
+            }
+
+            for (auto numThreads : threadCounts)
+            {
+                MultiStreamEngine engine(numStreams, numThreads);
+
+                for (int stream = 0; stream < numStreams; ++stream)
+                {
+                    engine.setGain(stream, gainOf(stream));
+                    engine.setModDepth(stream, depthOf(stream));
+                    engine.setModFrequency(stream, frequencyOf(stream));
+                }
+
+                engine.prepare(sampleRate);
+
+                const auto usPerCall = timeCallsMicroseconds(numCalls, [&](int)
+                {
+                    fillBuffer();
+                    engine.process(buffer.getArrayOfWritePointers(), blockSize);
+                });
+
+                // The engine caps the thread count for small stream sets
+                report(format("multi_stream", numStreams, engine.getNumThreads(), usPerCall));
+            }
+        }
+    }
+
+    //==============================================================================
+    void runProcessingSweep(const juce::ArgumentList& args, bool asJson, juce::StringArray& lines)
+    {
+        const auto numRuns = juce::jmax(2, args.containsOption("--runs") ? args.getValueForOption("--runs").getIntValue() : 10);
+
+        const auto blockSizes = parseList<int>(args, "--block-sizes", { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 });
+        const auto channelCounts = parseList<int>(args, "--channels", { 1, 2, 6, 12, 16 });
+        const auto sampleRates = parseList<double>(args, "--rates", { 44100.0, 48000.0, 96000.0, 192000.0 });
+        const auto states = parseStates(args);
+        const auto oversamplingChoices = parseOversampling(args);
+        const auto inputs = parseInputs(args);
+
+        const auto precisions = args.containsOption("--precision")
+                                  ? juce::StringArray::fromTokens(args.getValueForOption("--precision"), ",", {})
+                                  : juce::StringArray { "float", "double" };
+
+        const auto meteringModes = args.containsOption("--metering")
+                                     ? juce::StringArray::fromTokens(args.getValueForOption("--metering"), ",", {})
+                                     : juce::StringArray { "off", "on" };
+
+        if (! asJson)
+            lines.add(formatCsvHeader());
+
+        // Build the full sweep first, then run it
+        juce::Array<BenchCase> cases;
+
+        for (auto& precision : precisions)
+            for (auto sampleRate : sampleRates)
+                for (auto numChannels : channelCounts)
+                    for (auto blockSize : blockSizes)
+                        for (auto state : states)
+                            for (auto& metering : meteringModes)
+                                for (auto oversampling : oversamplingChoices)
+                                    for (auto input : inputs)
+                                        cases.add({ precision == "double", blockSize, numChannels, sampleRate, state,
+                                                    metering == "on", oversampling, input });
+
+        for (auto& benchCase : cases)
+        {
+            BenchResult result;
+
+            const auto supported = benchCase.doublePrecision ? runCase<double>(benchCase, numRuns, result)
+                                                             : runCase<float>(benchCase, numRuns, result);
+
+            if (! supported)
+            {
+                std::cerr << "Unsupported layout: " << benchCase.numChannels << " channels" << std::endl;
+                continue;
+            }
+
+            const auto line = formatResult(benchCase, result, asJson);
+
+            std::cerr << line << std::endl;
+            lines.add(line);
+        }
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    const auto asJson = args.getValueForOption("--format") == "jsonl";
+
+    // A single instance case, run as a child of --instances
+    if (args.containsOption("--instance-case"))
+    {
+        const auto result = runInstanceCase(args.getValueForOption("--instance-case").getIntValue(),
+                                            args.getValueForOption("--editors") == "on");
+        std::cout << formatInstanceResult(result, asJson) << std::endl;
+        return 0;
+    }
+
+    std::cerr << "Kernels: " << KernelDispatch::getName(KernelDispatch::getKernels().variant) << std::endl;
+
+    juce::StringArray lines;
+    auto succeeded = true;
+
+    if (args.containsOption("--state"))
+        succeeded = runStateSweep(args, asJson, lines);
+    else if (args.containsOption("--clipper"))
+        runClipperSweep(args, asJson, lines);
+    else if (args.containsOption("--presets"))
+        runPresetSweep(args, asJson, lines);
+    else if (args.containsOption("--streams"))
+        runStreamSweep(args, asJson, lines);
+    else if (args.containsOption("--instances"))
+        runInstanceSweep(args, asJson, lines);
+    else
+        runProcessingSweep(args, asJson, lines);
+
+    const auto output = lines.joinIntoString("\n") + "\n";
+
+    if (args.containsOption("--output"))
+    {
+        const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--output"));
+
+        if (! file.replaceWithText(output))
+        {
+            std::cerr << "Could not write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << output;
+    }
+
+    return succeeded ? 0 : 1;
+}
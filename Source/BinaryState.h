@@ -0,0 +1,95 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+//==============================================================================
+/**
+ * BinaryState reads and writes the plugin's compact state format: a small
+ * header followed by one little-endian float per parameter.
+ *
+ *     offset 0   uint32  magic ('SGbs')
+ *     offset 4   uint16  format version
+ *     offset 6   uint16  number of values
+ *     offset 8   float   plain parameter values, in ParameterIndex order
+ *
+ * Values are stored in parameter units rather than normalised, so a later
+ * range change doesn't move saved settings. Newer versions may only append
+ * values; readers take the ones they know and leave the rest.
+ *
+ * Neither direction allocates. The magic number differs from the one used by
+ * AudioProcessor::copyXmlToBinary, so older XML states are told apart safely.
+ */
+namespace BinaryState
+{
+    constexpr juce::uint32 magic = 0x73624753;     // "SGbs" when read as little-endian bytes
+    constexpr juce::uint16 currentVersion = 1;
+    constexpr size_t headerSize = 8;
+
+    constexpr size_t getSize(int numValues) noexcept
+    {
+        return headerSize + (size_t) numValues * sizeof(float);
+    }
+
+    template <typename IntType>
+    void writeLittleEndian(char* destination, IntType value) noexcept
+    {
+        value = juce::ByteOrder::swapIfBigEndian(value);
+        std::memcpy(destination, &value, sizeof(value));
+    }
+
+    // Writes a complete state to destination, which must hold getSize(numValues) bytes
+    inline void write(void* destination, const float* values, int numValues) noexcept
+    {
+        auto* bytes = static_cast<char*>(destination);
+
+        writeLittleEndian(bytes, magic);
+        writeLittleEndian(bytes + 4, currentVersion);
+        writeLittleEndian(bytes + 6, (juce::uint16) numValues);
+
+        for (int i = 0; i < numValues; ++i)
+        {
+            juce::uint32 bits;
+            std::memcpy(&bits, values + i, sizeof(bits));
+            writeLittleEndian(bytes + getSize(i), bits);
+        }
+    }
+
+    inline bool isBinaryState(const void* data, int sizeInBytes) noexcept
+    {
+        return data != nullptr
+            && sizeInBytes >= (int) headerSize
+            && juce::ByteOrder::littleEndianInt(data) == magic;
+    }
+
+    /** Reads up to maxValues values into destination and returns how many were
+        present, or -1 if the data isn't a complete binary state. Values that
+        aren't finite are returned as NaN so the caller can substitute defaults.
+    */
+    inline int read(const void* data, int sizeInBytes, float* destination, int maxValues) noexcept
+    {
+        if (! isBinaryState(data, sizeInBytes))
+            return -1;
+
+        auto* bytes = static_cast<const char*>(data);
+        const auto version = juce::ByteOrder::littleEndianShort(bytes + 4);
+        const auto numStored = (int) juce::ByteOrder::littleEndianShort(bytes + 6);
+
+        if (version == 0 || (size_t) sizeInBytes < getSize(numStored))
+            return -1;
+
+        const auto numRead = juce::jmin(numStored, maxValues);
+
+        for (int i = 0; i < numRead; ++i)
+        {
+            const auto bits = juce::ByteOrder::littleEndianInt(bytes + getSize(i));
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            destination[i] = std::isfinite(value) ? value : std::numeric_limits<float>::quiet_NaN();
+        }
+
+        return numRead;
+    }
+}
@@ -0,0 +1,254 @@
+#include "DummyAudioDevice.h"
+#include <chrono>
+#include <thread>
+
+//==============================================================================
+namespace
+{
+    const juce::StringArray deviceNames { "Sine", "Silence", "Loopback" };
+
+    // As many as the processor handles, so the headless engine can ask for any count it accepts
+    constexpr int maxChannels = 64;
+
+    class DummyAudioIODevice : public juce::AudioIODevice,
+                               private juce::Thread
+    {
+    public:
+        DummyAudioIODevice(const juce::String& deviceName)
+            : juce::AudioIODevice(deviceName, DummyAudioIODeviceType::typeName),
+              juce::Thread("Dummy audio device"),
+              inputSource((InputSource) juce::jmax(0, deviceNames.indexOf(deviceName)))
+        {
+        }
+
+        ~DummyAudioIODevice() override
+        {
+            close();
+        }
+
+        //==============================================================================
+        juce::StringArray getOutputChannelNames() override    { return getChannelNames("Output"); }
+        juce::StringArray getInputChannelNames() override     { return getChannelNames("Input"); }
+
+        juce::Array<double> getAvailableSampleRates() override  { return { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 }; }
+        juce::Array<int> getAvailableBufferSizes() override     { return { 16, 32, 64, 128, 256, 512, 1024, 2048 }; }
+        int getDefaultBufferSize() override                     { return 256; }
+
+        juce::String open(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels,
+                          double sampleRate, int bufferSizeSamples) override
+        {
+            close();
+
+            if (inputChannels.getHighestBit() >= maxChannels || outputChannels.getHighestBit() >= maxChannels)
+                return "The dummy device has at most " + juce::String(maxChannels) + " inputs and outputs";
+
+            activeInputs = inputChannels;
+            activeOutputs = outputChannels;
+
+            currentSampleRate = sampleRate > 0.0 ? sampleRate : 48000.0;
+            currentBufferSize = bufferSizeSamples > 0 ? bufferSizeSamples : getDefaultBufferSize();
+
+            // Every buffer the callback sees is allocated here, before the device starts
+            inputs.setSize(activeInputs.countNumberOfSetBits(), currentBufferSize);
+            outputs.setSize(activeOutputs.countNumberOfSetBits(), currentBufferSize);
+            inputs.clear();
+            outputs.clear();
+
+            sinePhase = 0.0;
+            xruns = 0;
+            opened = true;
+            return {};
+        }
+
+        void close() override
+        {
+            stop();
+            opened = false;
+        }
+
+        bool isOpen() override  { return opened; }
+
+        void start(juce::AudioIODeviceCallback* newCallback) override
+        {
+            if (! opened || newCallback == nullptr || isPlaying())
+                return;
+
+            newCallback->audioDeviceAboutToStart(this);
+            callback.store(newCallback);
+            startThread(juce::Thread::Priority::highest);
+        }
+
+        void stop() override
+        {
+            // Once the pointer is cleared and no block is running, the old callback can't be
+            // entered again, even if the thread is still on its way out
+            auto* oldCallback = callback.exchange(nullptr);
+
+            while (callbackRunning.load())
+                std::this_thread::yield();
+
+            stopThread(2000);
+
+            if (oldCallback != nullptr)
+                oldCallback->audioDeviceStopped();
+        }
+
+        bool isPlaying() override
+        {
+            return callback.load() != nullptr;
+        }
+
+        juce::String getLastError() override                { return {}; }
+
+        int getCurrentBufferSizeSamples() override          { return currentBufferSize; }
+        double getCurrentSampleRate() override              { return currentSampleRate; }
+        int getCurrentBitDepth() override                   { return 32; }
+
+        juce::BigInteger getActiveOutputChannels() const override   { return activeOutputs; }
+        juce::BigInteger getActiveInputChannels() const override    { return activeInputs; }
+
+        int getOutputLatencyInSamples() override            { return currentBufferSize; }
+        int getInputLatencyInSamples() override             { return currentBufferSize; }
+
+        int getXRunCount() const noexcept override          { return xruns.load(); }
+
+    private:
+        // In deviceNames order
+        enum class InputSource
+        {
+            sine,
+            silence,
+            loopback
+        };
+
+        //==============================================================================
+        static juce::StringArray getChannelNames(const juce::String& prefix)
+        {
+            juce::StringArray names;
+
+            for (int i = 0; i < maxChannels; ++i)
+                names.add(prefix + " " + juce::String(i + 1));
+
+            return names;
+        }
+
+        void fillInputs() noexcept
+        {
+            const auto numInputs = inputs.getNumChannels();
+
+            if (inputSource == InputSource::sine)
+            {
+                const auto increment = juce::MathConstants<double>::twoPi * 440.0 / currentSampleRate;
+                auto* first = numInputs > 0 ? inputs.getWritePointer(0) : nullptr;
+
+                for (int i = 0; i < currentBufferSize && first != nullptr; ++i)
+                {
+                    first[i] = 0.25f * (float) std::sin(sinePhase);
+                    sinePhase += increment;
+                }
+
+                sinePhase = std::fmod(sinePhase, juce::MathConstants<double>::twoPi);
+
+                for (int channel = 1; channel < numInputs; ++channel)
+                    inputs.copyFrom(channel, 0, inputs, 0, 0, currentBufferSize);
+            }
+            else if (inputSource == InputSource::loopback)
+            {
+                for (int channel = 0; channel < numInputs; ++channel)
+                {
+                    if (channel < outputs.getNumChannels())
+                        inputs.copyFrom(channel, 0, outputs, channel, 0, currentBufferSize);
+                    else
+                        inputs.clear(channel, 0, currentBufferSize);
+                }
+            }
+            else
+            {
+                inputs.clear();
+            }
+        }
+
+        void run() override
+        {
+            using Clock = std::chrono::steady_clock;
+
+            const auto period = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(currentBufferSize / currentSampleRate));
+
+            // The first period "plays" while the first block is computed
+            auto deadline = Clock::now() + period;
+
+            while (! threadShouldExit())
+            {
+                fillInputs();
+
+                // Raised before the pointer is read, so stop() either sees the flag or this
+                // block sees the cleared pointer
+                callbackRunning.store(true);
+
+                if (auto* currentCallback = callback.load())
+                    currentCallback->audioDeviceIOCallbackWithContext(inputs.getArrayOfReadPointers(), inputs.getNumChannels(),
+                                                                      outputs.getArrayOfWritePointers(), outputs.getNumChannels(),
+                                                                      currentBufferSize, {});
+
+                callbackRunning.store(false);
+
+                // This block had to be ready when the previous one finished playing
+                const auto now = Clock::now();
+
+                if (now > deadline)
+                {
+                    xruns.fetch_add(1, std::memory_order_relaxed);
+                    deadline = now;
+                }
+
+                std::this_thread::sleep_until(deadline);
+                deadline += period;
+            }
+        }
+
+        //==============================================================================
+        const InputSource inputSource;
+        juce::BigInteger activeInputs, activeOutputs;
+        double currentSampleRate = 48000.0;
+        int currentBufferSize = 256;
+        bool opened = false;
+
+        juce::AudioBuffer<float> inputs, outputs;
+        double sinePhase = 0.0;
+        std::atomic<int> xruns { 0 };
+
+        // The audio thread never locks; stop() waits for callbackRunning to drop instead
+        std::atomic<juce::AudioIODeviceCallback*> callback { nullptr };
+        std::atomic<bool> callbackRunning { false };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DummyAudioIODevice)
+    };
+}
+
+//==============================================================================
+DummyAudioIODeviceType::DummyAudioIODeviceType()
+    : juce::AudioIODeviceType(typeName)
+{
+}
+
+juce::StringArray DummyAudioIODeviceType::getDeviceNames(bool) const
+{
+    return deviceNames;
+}
+
+int DummyAudioIODeviceType::getIndexOfDevice(juce::AudioIODevice* device, bool) const
+{
+    return device != nullptr ? deviceNames.indexOf(device->getName()) : -1;
+}
+
+juce::AudioIODevice* DummyAudioIODeviceType::createDevice(const juce::String& outputDeviceName,
+                                                          const juce::String& inputDeviceName)
+{
+    const auto name = outputDeviceName.isNotEmpty() ? outputDeviceName : inputDeviceName;
+
+    if (name.isEmpty())
+        return new DummyAudioIODevice(deviceNames[0]);
+
+    return deviceNames.contains(name) ? new DummyAudioIODevice(name) : nullptr;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <juce_audio_devices/juce_audio_devices.h>
+
+//==============================================================================
+/**
+ * DummyAudioIODeviceType provides audio devices that need no sound card, so
+ * the headless engine can run on servers and CI machines.
+ *
+ * Each device calls its callback from its own thread on a fixed clock, one
+ * buffer period apart, the way a sound card's period interrupt would. A block
+ * that isn't finished by the end of the following period counts as an xrun,
+ * after which the clock skips ahead like a card recovering from an underrun.
+ *
+ * The device name picks what the inputs carry:
+ *   "Sine"      a 440 Hz tone at -12 dBFS on every input
+ *   "Silence"   zeros
+ *   "Loopback"  the outputs of the previous block
+ */
+class DummyAudioIODeviceType : public juce::AudioIODeviceType
+{
+public:
+    static constexpr const char* typeName = "Dummy";
+
+    DummyAudioIODeviceType();
+
+    //==============================================================================
+    void scanForDevices() override {}
+    juce::StringArray getDeviceNames(bool wantInputNames = false) const override;
+    int getDefaultDeviceIndex(bool) const override      { return 0; }
+    int getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override   { return false; }
+
+    juce::AudioIODevice* createDevice(const juce::String& outputDeviceName, const juce::String& inputDeviceName) override;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DummyAudioIODeviceType)
+};
@@ -0,0 +1,590 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+ * Inner loops that apply a gain or a gain envelope to every channel of a block.
+ *
+ * Work is done in tiles of tileSize samples, so the envelope slice and each
+ * channel's slice stay in L1 while all channels are processed. The channel
+ * loop is specialised at compile time for common bus widths (mono, stereo,
+ * quad/first-order ambisonics, 5.1, 7.1, 7.1.4 and third-order ambisonics);
+ * other counts use the same code with a runtime channel count.
+ *
+ * The loops are plain C++ so the compiler can vectorise them. Metering and
+ * the optional output stage are folded into the same tile pass, while the
+ * data is still in L1. Stereo envelopes and the mid/side matrix have their own
+ * two-channel pass, since they mix the channels. processStreams is the
+ * multi-stream counterpart: many mono streams with their own gain and LFO,
+ * vectorised across the streams rather than along the samples.
+ *
+ * The functions live in an inline namespace named after the instruction set
+ * they are compiled for, so KernelDispatch can build the same loops once per
+ * ISA without the copies colliding at link time. Code outside the kernel
+ * variants sees them as plain GainKernels:: functions built for the baseline.
+ */
+#ifndef SIMPLEGAIN_KERNEL_ISA
+ #define SIMPLEGAIN_KERNEL_ISA baseline
+#endif
+
+namespace GainKernels
+{
+    // Samples per tile
+    constexpr int tileSize = 256;
+
+    //==============================================================================
+    // Peak and sum of squares over every channel
+    struct LevelAccumulator
+    {
+        double peak = 0.0;
+        double sumSquares = 0.0;
+        juce::int64 numSamples = 0;
+    };
+
+    //==============================================================================
+    // Soft clipper and ceiling applied after the gain, inside the same tile pass
+    struct OutputStage
+    {
+        enum class Mode
+        {
+            off,
+            softClip,   // rational tanh approximation, reaching the ceiling at 3x its level
+            hardClip
+        };
+
+        Mode mode = Mode::off;
+        float ceiling = 1.0f;   // linear
+
+        bool isActive() const noexcept  { return mode != Mode::off; }
+    };
+
+    //==============================================================================
+    // Streams processed together by processStreams. Each group's LFOs are evaluated at
+    // control points at most streamControlInterval samples apart, streamPointsPerChunk
+    // points at a time, and the envelope is interpolated linearly in between.
+    constexpr int streamGroupSize = 64;
+    constexpr int streamControlInterval = 16;
+    constexpr int streamPointsPerChunk = 16;
+
+    // Per-stream state for processStreams, one array entry per stream. Gain and depth
+    // step towards their targets while rampRemaining counts down.
+    struct StreamState
+    {
+        enum class Shape
+        {
+            sine,
+            triangle,
+            saw,
+            square
+        };
+
+        Shape shape = Shape::sine;
+        juce::uint32* phase = nullptr;              // fixed point, 2^32 per cycle
+        const juce::uint32* increment = nullptr;    // per sample, at most half a cycle
+        float* gain = nullptr;                      // linear
+        const float* gainStep = nullptr;
+        const float* gainTarget = nullptr;
+        float* depth = nullptr;
+        const float* depthStep = nullptr;
+        const float* depthTarget = nullptr;
+        int* rampRemaining = nullptr;
+    };
+
+    //==============================================================================
+    inline namespace SIMPLEGAIN_KERNEL_ISA
+    {
+    // Library helpers such as juce::jmin are inline functions shared with the baseline code, so
+    // the linker could keep a copy built with this variant's flags; the kernels use their own
+    inline int minOf(int a, int b) noexcept
+    {
+        return a < b ? a : b;
+    }
+
+    template <typename SampleType>
+    inline void accumulateLevels(const SampleType* data, int numSamples, LevelAccumulator& levels) noexcept
+    {
+        // Independent lanes so the reduction maps onto SIMD registers
+        constexpr int numLanes = 8;
+        SampleType peaks[numLanes] = {};
+        SampleType squares[numLanes] = {};
+        int i = 0;
+
+        for (; i + numLanes <= numSamples; i += numLanes)
+        {
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const auto sample = data[i + lane];
+                const auto magnitude = sample < 0 ? -sample : sample;
+                peaks[lane] = magnitude > peaks[lane] ? magnitude : peaks[lane];
+                squares[lane] += sample * sample;
+            }
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            const auto sample = data[i];
+            const auto magnitude = sample < 0 ? -sample : sample;
+            peaks[0] = magnitude > peaks[0] ? magnitude : peaks[0];
+            squares[0] += sample * sample;
+        }
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            levels.peak = peaks[lane] > levels.peak ? (double) peaks[lane] : levels.peak;
+            levels.sumSquares += (double) squares[lane];
+        }
+
+        levels.numSamples += numSamples;
+    }
+
+    // Adds source into destination, as if the measured samples had been scaled by gain
+    inline void mergeLevels(LevelAccumulator& destination, const LevelAccumulator& source, double gain = 1.0) noexcept
+    {
+        const auto peak = source.peak * (gain < 0.0 ? -gain : gain);
+        destination.peak = peak > destination.peak ? peak : destination.peak;
+        destination.sumSquares += source.sumSquares * gain * gain;
+        destination.numSamples += source.numSamples;
+    }
+
+    //==============================================================================
+    // NumChannels == 0 means "use numChannels at runtime"
+    template <int NumChannels, typename SampleType, typename TileFunction>
+    inline void processTiles(SampleType* const* channels, int numChannels, int startSample, int numSamples,
+                             TileFunction&& tileFunction) noexcept
+    {
+        const auto channelCount = NumChannels > 0 ? NumChannels : numChannels;
+
+        for (int tileStart = 0; tileStart < numSamples; tileStart += tileSize)
+        {
+            const auto tileLength = minOf(tileSize, numSamples - tileStart);
+
+            for (int channel = 0; channel < channelCount; ++channel)
+                tileFunction(channels[channel] + startSample + tileStart, tileStart, tileLength);
+        }
+    }
+
+    template <typename SampleType, typename TileFunction>
+    inline void forEachChannelTile(SampleType* const* channels, int numChannels, int startSample, int numSamples,
+                                   TileFunction&& tileFunction) noexcept
+    {
+        switch (numChannels)
+        {
+            case 0:  break;
+            case 1:  processTiles<1>(channels, numChannels, startSample, numSamples, tileFunction); break;
+            case 2:  processTiles<2>(channels, numChannels, startSample, numSamples, tileFunction); break;
+            case 4:  processTiles<4>(channels, numChannels, startSample, numSamples, tileFunction); break;
+            case 6:  processTiles<6>(channels, numChannels, startSample, numSamples, tileFunction); break;
+            case 8:  processTiles<8>(channels, numChannels, startSample, numSamples, tileFunction); break;
+            case 12: processTiles<12>(channels, numChannels, startSample, numSamples, tileFunction); break;
+            case 16: processTiles<16>(channels, numChannels, startSample, numSamples, tileFunction); break;
+            default: processTiles<0>(channels, numChannels, startSample, numSamples, tileFunction); break;
+        }
+    }
+
+    //==============================================================================
+    // True if every sample on every channel is below threshold in magnitude. Checks a
+    // tile at a time and stops at the first loud one, so audible blocks cost one tile.
+    template <typename SampleType>
+    inline bool isSilent(const SampleType* const* channels, int numChannels, int startSample, int numSamples,
+                         SampleType threshold) noexcept
+    {
+        constexpr int numLanes = 8;
+
+        for (int tileStart = 0; tileStart < numSamples; tileStart += tileSize)
+        {
+            const auto tileLength = minOf(tileSize, numSamples - tileStart);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                const auto* data = channels[channel] + startSample + tileStart;
+                SampleType peaks[numLanes] = {};
+                int i = 0;
+
+                for (; i + numLanes <= tileLength; i += numLanes)
+                {
+                    for (int lane = 0; lane < numLanes; ++lane)
+                    {
+                        const auto sample = data[i + lane];
+                        const auto magnitude = sample < 0 ? -sample : sample;
+                        peaks[lane] = magnitude > peaks[lane] ? magnitude : peaks[lane];
+                    }
+                }
+
+                for (; i < tileLength; ++i)
+                {
+                    const auto magnitude = data[i] < 0 ? -data[i] : data[i];
+                    peaks[0] = magnitude > peaks[0] ? magnitude : peaks[0];
+                }
+
+                for (int lane = 0; lane < numLanes; ++lane)
+                    if (peaks[lane] >= threshold)
+                        return false;
+            }
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    // Input levels only, for blocks that leave the signal untouched
+    template <typename SampleType>
+    inline void measureLevels(SampleType* const* channels, int numChannels, int startSample, int numSamples,
+                              LevelAccumulator& levels) noexcept
+    {
+        forEachChannelTile(channels, numChannels, startSample, numSamples,
+                           [&levels](SampleType* data, int, int tileLength)
+                           {
+                               accumulateLevels(data, tileLength, levels);
+                           });
+    }
+
+    //==============================================================================
+    // x * (27 + x^2) / (27 + 9x^2): matches tanh's slope at 0 and meets +-1 with zero
+    // slope at x = +-3, so clamping there keeps the curve smooth. It is plain
+    // arithmetic, so it vectorises where std::tanh can't.
+    template <typename SampleType>
+    inline SampleType softClip(SampleType x) noexcept
+    {
+        constexpr auto limit = (SampleType) 3;
+        x = x < -limit ? -limit : (x > limit ? limit : x);
+
+        const auto x2 = x * x;
+        return x * ((SampleType) 27 + x2) / ((SampleType) 27 + (SampleType) 9 * x2);
+    }
+
+    template <typename SampleType>
+    inline void applyOutputStage(SampleType* data, int numSamples, const OutputStage& stage) noexcept
+    {
+        const auto ceiling = (SampleType) stage.ceiling;
+
+        if (stage.mode == OutputStage::Mode::softClip)
+        {
+            const auto inverseCeiling = (SampleType) 1 / ceiling;
+
+            for (int i = 0; i < numSamples; ++i)
+                data[i] = ceiling * softClip(data[i] * inverseCeiling);
+        }
+        else if (stage.mode == OutputStage::Mode::hardClip)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                data[i] = data[i] < -ceiling ? -ceiling : (data[i] > ceiling ? ceiling : data[i]);
+        }
+    }
+
+    //==============================================================================
+    // channels[c][startSample + i] *= gain, optionally measuring the input first and
+    // running the output stage. Output levels are only measured when asked for; without
+    // an output stage they follow from the input levels.
+    template <typename SampleType>
+    inline void applyGain(SampleType* const* channels, int numChannels, int startSample,
+                          SampleType gain, int numSamples, LevelAccumulator* inputLevels = nullptr,
+                          LevelAccumulator* outputLevels = nullptr, const OutputStage* outputStage = nullptr) noexcept
+    {
+        forEachChannelTile(channels, numChannels, startSample, numSamples,
+                           [gain, inputLevels, outputLevels, outputStage](SampleType* data, int, int tileLength)
+                           {
+                               if (inputLevels != nullptr)
+                                   accumulateLevels(data, tileLength, *inputLevels);
+
+                               for (int i = 0; i < tileLength; ++i)
+                                   data[i] *= gain;
+
+                               if (outputStage != nullptr)
+                                   applyOutputStage(data, tileLength, *outputStage);
+
+                               if (outputLevels != nullptr)
+                                   accumulateLevels(data, tileLength, *outputLevels);
+                           });
+    }
+
+    // channels[c][startSample + i] *= envelope[i], optionally measuring input and output
+    // and running the output stage
+    template <typename SampleType>
+    inline void applyEnvelope(SampleType* const* channels, int numChannels, int startSample,
+                              const SampleType* envelope, int numSamples,
+                              LevelAccumulator* inputLevels = nullptr, LevelAccumulator* outputLevels = nullptr,
+                              const OutputStage* outputStage = nullptr) noexcept
+    {
+        forEachChannelTile(channels, numChannels, startSample, numSamples,
+                           [envelope, inputLevels, outputLevels, outputStage](SampleType* data, int tileStart, int tileLength)
+                           {
+                               const auto* tileEnvelope = envelope + tileStart;
+
+                               if (inputLevels != nullptr)
+                                   accumulateLevels(data, tileLength, *inputLevels);
+
+                               for (int i = 0; i < tileLength; ++i)
+                                   data[i] *= tileEnvelope[i];
+
+                               if (outputStage != nullptr)
+                                   applyOutputStage(data, tileLength, *outputStage);
+
+                               if (outputLevels != nullptr)
+                                   accumulateLevels(data, tileLength, *outputLevels);
+                           });
+    }
+
+    //==============================================================================
+    // A pair of envelopes on a stereo bus, in one pass over both channels. Left/right:
+    // left *= first, right *= second. Mid/side: encodes M = (L + R) / 2 and S = (L - R) / 2,
+    // scales M by first and S by second and decodes, folded into a 2x2 matrix per sample
+    // so each tile is read and written once.
+    template <typename SampleType>
+    inline void applyStereoEnvelopes(SampleType* const* channels, int startSample,
+                                     const SampleType* first, const SampleType* second, int numSamples, bool midSide,
+                                     LevelAccumulator* inputLevels = nullptr, LevelAccumulator* outputLevels = nullptr,
+                                     const OutputStage* outputStage = nullptr) noexcept
+    {
+        constexpr auto half = (SampleType) 0.5;
+
+        for (int tileStart = 0; tileStart < numSamples; tileStart += tileSize)
+        {
+            const auto tileLength = minOf(tileSize, numSamples - tileStart);
+            auto* left = channels[0] + startSample + tileStart;
+            auto* right = channels[1] + startSample + tileStart;
+            const auto* tileFirst = first + tileStart;
+            const auto* tileSecond = second + tileStart;
+
+            if (inputLevels != nullptr)
+            {
+                accumulateLevels(left, tileLength, *inputLevels);
+                accumulateLevels(right, tileLength, *inputLevels);
+            }
+
+            if (midSide)
+            {
+                for (int i = 0; i < tileLength; ++i)
+                {
+                    const auto direct = half * (tileFirst[i] + tileSecond[i]);
+                    const auto cross = half * (tileFirst[i] - tileSecond[i]);
+                    const auto l = left[i];
+                    const auto r = right[i];
+
+                    left[i] = direct * l + cross * r;
+                    right[i] = cross * l + direct * r;
+                }
+            }
+            else
+            {
+                for (int i = 0; i < tileLength; ++i)
+                {
+                    left[i] *= tileFirst[i];
+                    right[i] *= tileSecond[i];
+                }
+            }
+
+            for (auto* data : { left, right })
+            {
+                if (outputStage != nullptr)
+                    applyOutputStage(data, tileLength, *outputStage);
+
+                if (outputLevels != nullptr)
+                    accumulateLevels(data, tileLength, *outputLevels);
+            }
+        }
+    }
+
+    //==============================================================================
+    // The LFO shapes on a fixed-point phase. They only use integer bit work and plain
+    // arithmetic, so they vectorise across streams; the sine is a polynomial rather
+    // than ModulationLfo's table, since a table lookup per stream would be a gather.
+    inline float phaseToFloat(juce::uint32 phase) noexcept
+    {
+        return (float) (int) (phase >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // |p - 1/2|, 0..1/2
+    inline float distanceFromHalf(juce::uint32 phase) noexcept
+    {
+        return phaseToFloat(phase >= 0x80000000u ? phase - 0x80000000u : 0x80000000u - phase);
+    }
+
+    // +1 for the first half cycle, -1 for the second
+    inline float halfCycleSign(juce::uint32 phase) noexcept
+    {
+        return 1.0f - (float) (int) ((phase >> 30) & 2u);
+    }
+
+    inline float streamSine(juce::uint32 phase) noexcept
+    {
+        // sin(2 pi p) = +-cos(2 pi (|p - 1/2| - 1/4)), and over -1/4..1/4 cycles the
+        // even Taylor series to x^12 is within 1e-8
+        const auto x = (distanceFromHalf(phase) - 0.25f) * 6.28318530718f;
+        const auto x2 = x * x;
+
+        return halfCycleSign(phase)
+             * (1.0f + x2 * (-1.0f / 2.0f + x2 * (1.0f / 24.0f + x2 * (-1.0f / 720.0f + x2 * (1.0f / 40320.0f
+                     + x2 * (-1.0f / 3628800.0f + x2 * (1.0f / 479001600.0f)))))));
+    }
+
+    inline float streamTriangle(juce::uint32 phase) noexcept
+    {
+        return 1.0f - 4.0f * distanceFromHalf(phase + 0x40000000u);
+    }
+
+    inline float streamSaw(juce::uint32 phase) noexcept
+    {
+        return 2.0f * phaseToFloat(phase + 0x80000000u) - 1.0f;
+    }
+
+    inline float streamSquare(juce::uint32 phase) noexcept
+    {
+        return halfCycleSign(phase);
+    }
+
+    // A group's state, copied out of the StreamState arrays so the loops across
+    // streams work on local arrays that can't alias each other or the audio
+    struct StreamGroup
+    {
+        juce::uint32 phase[streamGroupSize];
+        juce::uint32 increment[streamGroupSize];
+        float gain[streamGroupSize];
+        float gainStep[streamGroupSize];
+        float depth[streamGroupSize];
+        float depthStep[streamGroupSize];
+        int rampRemaining[streamGroupSize];
+    };
+
+    // points[k * streamGroupSize + s] = gain * (1 + depth * lfo) for every stream in the group,
+    // at the end of each of numSegments segments; points[0] already holds the first start.
+    // The loops run across streams, so each point is one vector operation per few streams.
+    template <typename SampleType, typename ShapeFunction>
+    inline void renderStreamPoints(StreamGroup& group, int groupSize, SampleType* points, int numSegments,
+                                   int interval, int lastLength, ShapeFunction&& shapeFunction) noexcept
+    {
+        for (int k = 1; k <= numSegments; ++k)
+        {
+            const auto length = k < numSegments ? interval : lastLength;
+            auto* row = points + k * streamGroupSize;
+
+            for (int s = 0; s < groupSize; ++s)
+            {
+                const auto steps = group.rampRemaining[s] < length ? group.rampRemaining[s] : length;
+                group.gain[s] += group.gainStep[s] * (float) steps;
+                group.depth[s] += group.depthStep[s] * (float) steps;
+                group.rampRemaining[s] -= steps;
+                group.phase[s] += group.increment[s] * (juce::uint32) length;
+
+                const auto lfo = (SampleType) shapeFunction(group.phase[s]);
+                row[s] = (SampleType) group.gain[s] * ((SampleType) 1 + (SampleType) group.depth[s] * lfo);
+            }
+        }
+    }
+
+    //==============================================================================
+    // streams[s][startSample + i] *= gain[s] * (1 + depth[s] * lfo[s]) for streams
+    // firstStream..firstStream + numStreams, each a mono buffer with its own state.
+    //
+    // Streams are taken streamGroupSize at a time. For each chunk of a block the
+    // group's control points are rendered across the streams, then each stream's
+    // chunk is scaled by the interpolated envelope in one contiguous pass. Like
+    // ModulationLfo's control rate, the interval is only as long as still leaves
+    // 64 points per cycle of the group's fastest LFO; audio-rate LFOs get a point
+    // every sample.
+    template <typename SampleType>
+    inline void processStreams(SampleType* const* streams, const StreamState& state, int firstStream, int numStreams,
+                               int startSample, int numSamples) noexcept
+    {
+        StreamGroup group;
+        alignas(64) SampleType points[(streamPointsPerChunk + 1) * streamGroupSize];
+
+        const auto endStream = firstStream + numStreams;
+
+        for (int groupStart = firstStream; groupStart < endStream; groupStart += streamGroupSize)
+        {
+            const auto groupSize = endStream - groupStart < streamGroupSize ? endStream - groupStart : streamGroupSize;
+            juce::uint32 maxIncrement = 0;
+
+            for (int s = 0; s < groupSize; ++s)
+            {
+                const auto stream = groupStart + s;
+                group.phase[s] = state.phase[stream];
+                group.increment[s] = state.increment[stream];
+                group.gain[s] = state.gain[stream];
+                group.gainStep[s] = state.gainStep[stream];
+                group.depth[s] = state.depth[stream];
+                group.depthStep[s] = state.depthStep[stream];
+                group.rampRemaining[s] = state.rampRemaining[stream];
+                maxIncrement = group.increment[s] > maxIncrement ? group.increment[s] : maxIncrement;
+            }
+
+            // At least 64 points per cycle: increment * interval <= 2^32 / 64
+            auto interval = streamControlInterval;
+
+            while (interval > 1 && (juce::uint64) maxIncrement * (juce::uint64) interval > (1u << 26))
+                interval /= 2;
+
+            auto renderWith = [&](auto&& shapeFunction, int numSegments, int lastLength)
+            {
+                // Called with no segments to fill in the starting point
+                if (numSegments == 0)
+                {
+                    for (int s = 0; s < groupSize; ++s)
+                        points[s] = (SampleType) group.gain[s]
+                                  * ((SampleType) 1 + (SampleType) group.depth[s] * (SampleType) shapeFunction(group.phase[s]));
+                    return;
+                }
+
+                renderStreamPoints(group, groupSize, points, numSegments, interval, lastLength, shapeFunction);
+            };
+
+            auto render = [&](int numSegments, int lastLength)
+            {
+                switch (state.shape)
+                {
+                    case StreamState::Shape::sine:      renderWith([](juce::uint32 p) { return streamSine(p); }, numSegments, lastLength); break;
+                    case StreamState::Shape::triangle:  renderWith([](juce::uint32 p) { return streamTriangle(p); }, numSegments, lastLength); break;
+                    case StreamState::Shape::saw:       renderWith([](juce::uint32 p) { return streamSaw(p); }, numSegments, lastLength); break;
+                    case StreamState::Shape::square:    renderWith([](juce::uint32 p) { return streamSquare(p); }, numSegments, lastLength); break;
+                }
+            };
+
+            render(0, 0);
+
+            const auto chunkLength = interval * streamPointsPerChunk;
+
+            for (int chunkStart = 0; chunkStart < numSamples; chunkStart += chunkLength)
+            {
+                const auto chunkSamples = numSamples - chunkStart < chunkLength ? numSamples - chunkStart : chunkLength;
+                const auto numSegments = (chunkSamples + interval - 1) / interval;
+                const auto lastLength = chunkSamples - (numSegments - 1) * interval;
+
+                render(numSegments, lastLength);
+
+                for (int s = 0; s < groupSize; ++s)
+                {
+                    auto* data = streams[groupStart + s] + startSample + chunkStart;
+
+                    for (int k = 0; k < numSegments; ++k)
+                    {
+                        const auto length = k < numSegments - 1 ? interval : lastLength;
+                        const auto start = points[k * streamGroupSize + s];
+                        const auto delta = (points[(k + 1) * streamGroupSize + s] - start) / (SampleType) length;
+
+                        for (int i = 0; i < length; ++i)
+                            data[i] *= start + delta * (SampleType) i;
+
+                        data += length;
+                    }
+                }
+
+                // The last point starts the next chunk
+                for (int s = 0; s < groupSize; ++s)
+                    points[s] = points[numSegments * streamGroupSize + s];
+            }
+
+            // Finished ramps land exactly on their targets
+            for (int s = 0; s < groupSize; ++s)
+            {
+                const auto stream = groupStart + s;
+                const auto finished = group.rampRemaining[s] == 0;
+                state.phase[stream] = group.phase[s];
+                state.gain[stream] = finished ? state.gainTarget[stream] : group.gain[s];
+                state.depth[stream] = finished ? state.depthTarget[stream] : group.depth[s];
+                state.rampRemaining[stream] = group.rampRemaining[s];
+            }
+        }
+    }
+    } // inline namespace SIMPLEGAIN_KERNEL_ISA
+}
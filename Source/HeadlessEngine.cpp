@@ -0,0 +1,355 @@
+#include "HeadlessEngine.h"
+#include <cerrno>
+#include <cstring>
+
+#if JUCE_LINUX
+ #include <pthread.h>
+ #include <sched.h>
+ #include <sys/mman.h>
+
+ #if defined(__GLIBC__)
+  #include <malloc.h>
+ #endif
+#endif
+
+//==============================================================================
+namespace
+{
+    // Deeper than any call chain below the device callback
+    constexpr int stackPrefaultBytes = 256 * 1024;
+
+    const char* getRealtimeDescription(HeadlessEngine::RealtimeState state) noexcept
+    {
+        switch (state)
+        {
+            case HeadlessEngine::RealtimeState::raised:             return "raised";
+            case HeadlessEngine::RealtimeState::alreadyRealtime:    return "driver";
+            case HeadlessEngine::RealtimeState::failed:             return "failed";
+            case HeadlessEngine::RealtimeState::notAttempted:
+            default:                                                return "off";
+        }
+    }
+}
+
+//==============================================================================
+juce::String HeadlessEngine::Status::toString() const
+{
+    auto percent = [](double value) { return juce::String(value, 1) + "%"; };
+
+    auto text = juce::String(runningSeconds, 1) + " s  "
+              + juce::String(numCallbacks) + " callbacks  "
+              + "xruns " + (deviceXRuns >= 0 ? juce::String(deviceXRuns) : juce::String("n/a"))
+              + "  late " + juce::String(lateCallbacks)
+              + "  overruns " + juce::String(callbackTiming.numOverruns)
+              + "  callback " + percent(callbackTiming.getAverageBudgetPercent())
+              + " (max " + percent(callbackTiming.maxBudgetPercent) + ")"
+              + "  dsp " + percent(processorTiming.getAverageBudgetPercent())
+              + "  rt " + getRealtimeDescription(realtime);
+
+    if (realtime == RealtimeState::raised || realtime == RealtimeState::alreadyRealtime)
+        text << " " << realtimePriority;
+
+    return text + "  mlock " + (memoryLocked ? "on" : "off");
+}
+
+juce::String HeadlessEngine::Status::toJson() const
+{
+    auto* object = new juce::DynamicObject();
+    object->setProperty("device_type", deviceType);
+    object->setProperty("device", deviceName);
+    object->setProperty("sample_rate", sampleRate);
+    object->setProperty("buffer_size", bufferSize);
+    object->setProperty("latency_samples", latencySamples);
+    object->setProperty("seconds", runningSeconds);
+    object->setProperty("callbacks", (juce::int64) numCallbacks);
+    object->setProperty("xruns", deviceXRuns);
+    object->setProperty("late_callbacks", (juce::int64) lateCallbacks);
+    object->setProperty("realtime", getRealtimeDescription(realtime));
+    object->setProperty("realtime_priority", realtimePriority);
+
+    if (realtime == RealtimeState::failed)
+        object->setProperty("realtime_error", juce::String(std::strerror(realtimeError)));
+
+    object->setProperty("memory_locked", memoryLocked);
+
+    if (memoryLockError.isNotEmpty())
+        object->setProperty("memory_lock_error", memoryLockError);
+
+    object->setProperty("callback", juce::JSON::parse(callbackTiming.toJson()));
+    object->setProperty("processor", juce::JSON::parse(processorTiming.toJson()));
+    return juce::JSON::toString(juce::var(object));
+}
+
+//==============================================================================
+HeadlessEngine::HeadlessEngine()
+{
+    // The platform types have to be created first; adding a type to an empty
+    // list would stop the device manager creating them at all
+    deviceManager.getAvailableDeviceTypes();
+    deviceManager.addAudioDeviceType(std::make_unique<DummyAudioIODeviceType>());
+}
+
+HeadlessEngine::~HeadlessEngine()
+{
+    stop();
+}
+
+juce::String HeadlessEngine::start(const Options& newOptions)
+{
+    stop();
+    options = newOptions;
+
+    if (options.lockMemory)
+        lockMemory();
+
+    juce::AudioIODeviceType* type = nullptr;
+
+    for (auto* candidate : deviceManager.getAvailableDeviceTypes())
+    {
+        if (options.deviceType.isEmpty() || candidate->getTypeName().equalsIgnoreCase(options.deviceType))
+        {
+            type = candidate;
+            break;
+        }
+    }
+
+    if (type == nullptr)
+        return "Unknown device type: " + options.deviceType;
+
+    deviceManager.setCurrentAudioDeviceType(type->getTypeName(), true);
+    type->scanForDevices();
+
+    auto setup = deviceManager.getAudioDeviceSetup();
+    const auto outputNames = type->getDeviceNames(false);
+    const auto inputNames = type->getDeviceNames(true);
+
+    setup.outputDeviceName = options.outputDevice.isNotEmpty() ? options.outputDevice
+                                                               : outputNames[type->getDefaultDeviceIndex(false)];
+    setup.inputDeviceName = options.inputDevice.isNotEmpty() ? options.inputDevice
+                                                             : inputNames[type->getDefaultDeviceIndex(true)];
+
+    if (! type->hasSeparateInputsAndOutputs())
+        setup.inputDeviceName = setup.outputDeviceName;
+
+    if (options.numInputChannels == 0)
+        setup.inputDeviceName = {};
+
+    setup.sampleRate = options.sampleRate;
+    setup.bufferSize = options.bufferSize;
+    setup.inputChannels.clear();
+    setup.outputChannels.clear();
+    setup.inputChannels.setRange(0, options.numInputChannels, true);
+    setup.outputChannels.setRange(0, options.numOutputChannels, true);
+    setup.useDefaultInputChannels = false;
+    setup.useDefaultOutputChannels = false;
+
+    const auto error = deviceManager.setAudioDeviceSetup(setup, true);
+
+    if (error.isNotEmpty())
+        return error;
+
+    auto* device = deviceManager.getCurrentAudioDevice();
+
+    if (device == nullptr)
+        return "No audio device could be opened";
+
+    // Drivers open what they have rather than failing, which would skew a run with fewer channels
+    if (device->getActiveInputChannels().countNumberOfSetBits() < options.numInputChannels
+        || device->getActiveOutputChannels().countNumberOfSetBits() < options.numOutputChannels)
+    {
+        deviceManager.closeAudioDevice();
+        return "The device has fewer than " + juce::String(options.numInputChannels) + " inputs or "
+                 + juce::String(options.numOutputChannels) + " outputs";
+    }
+
+    // Created the way the standalone wrapper creates it
+    juce::AudioProcessor::setTypeOfNextNewPlugin(juce::AudioProcessor::wrapperType_Standalone);
+    processor = std::make_unique<SimpleGainProcessor>();
+    juce::AudioProcessor::setTypeOfNextNewPlugin(juce::AudioProcessor::wrapperType_Undefined);
+
+    if (options.stateFile != juce::File())
+    {
+        juce::MemoryBlock state;
+
+        if (! options.stateFile.loadFileAsData(state))
+        {
+            processor = nullptr;
+            return "Could not read " + options.stateFile.getFullPathName();
+        }
+
+        processor->setStateInformation(state.getData(), (int) state.getSize());
+    }
+
+    if (options.program >= 0)
+        processor->setCurrentProgram(options.program);
+
+    startTicks = juce::Time::getHighResolutionTicks();
+    player.setProcessor(processor.get());
+    deviceManager.addAudioCallback(this);
+    return {};
+}
+
+void HeadlessEngine::stop()
+{
+    if (processor == nullptr)
+        return;
+
+    deviceManager.removeAudioCallback(this);
+    player.setProcessor(nullptr);
+    deviceManager.closeAudioDevice();
+    processor = nullptr;
+}
+
+HeadlessEngine::Status HeadlessEngine::getStatus()
+{
+    Status status;
+
+    if (auto* device = deviceManager.getCurrentAudioDevice())
+    {
+        status.deviceType = device->getTypeName();
+        status.deviceName = device->getName();
+        status.sampleRate = device->getCurrentSampleRate();
+        status.bufferSize = device->getCurrentBufferSizeSamples();
+        status.latencySamples = device->getInputLatencyInSamples() + device->getOutputLatencyInSamples();
+        status.deviceXRuns = device->getXRunCount();
+    }
+
+    status.runningSeconds = startTicks != 0 ? juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks)
+                                            : 0.0;
+    status.numCallbacks = numCallbacks.load(std::memory_order_relaxed);
+    status.lateCallbacks = lateCallbacks.load(std::memory_order_relaxed);
+
+    callbackMonitor.update();
+    status.callbackTiming = callbackMonitor.getStatistics();
+
+    if (processor != nullptr)
+    {
+        auto& processorMonitor = processor->getPerformanceMonitor();
+        processorMonitor.update();
+        status.processorTiming = processorMonitor.getStatistics();
+    }
+
+    status.realtime = realtimeState.load();
+    status.realtimePriority = realtimePriority.load();
+    status.realtimeError = realtimeError.load();
+    status.memoryLocked = memoryLocked;
+    status.memoryLockError = memoryLockError;
+    return status;
+}
+
+juce::String HeadlessEngine::describeDevices()
+{
+    juce::String text;
+
+    for (auto* type : deviceManager.getAvailableDeviceTypes())
+    {
+        type->scanForDevices();
+        text << type->getTypeName() << "\n";
+
+        for (auto wantInputs : { false, true })
+            for (auto& name : type->getDeviceNames(wantInputs))
+                text << "  " << (wantInputs ? "input:  " : "output: ") << name << "\n";
+    }
+
+    return text;
+}
+
+//==============================================================================
+void HeadlessEngine::lockMemory()
+{
+   #if JUCE_LINUX
+    #if defined(__GLIBC__)
+    // Freed memory stays in the heap instead of going back to the OS, and large
+    // blocks come from the heap rather than fresh mappings, so locked pages stay locked
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    #endif
+
+    // Everything mapped now and later is faulted in and kept resident, including
+    // the buffers the device and processor allocate when they start
+    memoryLocked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+
+    if (! memoryLocked)
+        memoryLockError = juce::String("mlockall: ") + std::strerror(errno) + " (see RLIMIT_MEMLOCK)";
+   #else
+    memoryLockError = "not supported on this platform";
+   #endif
+}
+
+void HeadlessEngine::prepareAudioThread() noexcept
+{
+   #if JUCE_LINUX
+    int policy = 0;
+    sched_param parameters {};
+    pthread_getschedparam(pthread_self(), &policy, &parameters);
+
+    if (policy == SCHED_FIFO || policy == SCHED_RR)
+    {
+        realtimeState = RealtimeState::alreadyRealtime;
+        realtimePriority = parameters.sched_priority;
+    }
+    else if (options.realtimePriority > 0)
+    {
+        parameters.sched_priority = juce::jlimit(sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO),
+                                                 options.realtimePriority);
+        const auto result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+
+        realtimeState = result == 0 ? RealtimeState::raised : RealtimeState::failed;
+        realtimePriority = result == 0 ? parameters.sched_priority : 0;
+        realtimeError = result;
+    }
+
+   #endif
+
+    // Touch the stack the callback will grow into, so its first deep call doesn't fault
+    volatile char stack[stackPrefaultBytes];
+
+    for (int i = 0; i < stackPrefaultBytes; i += 4096)
+        stack[i] = 0;
+}
+
+//==============================================================================
+void HeadlessEngine::audioDeviceIOCallbackWithContext(const float* const* inputChannelData, int numInputChannels,
+                                                      float* const* outputChannelData, int numOutputChannels,
+                                                      int numSamples, const juce::AudioIODeviceCallbackContext& context)
+{
+    if (! audioThreadPrepared)
+    {
+        prepareAudioThread();
+        audioThreadPrepared = true;
+    }
+
+    const auto now = juce::Time::getHighResolutionTicks();
+
+    if (lastCallbackTicks != 0 && now - lastCallbackTicks > lateCallbackTicks)
+        lateCallbacks.fetch_add(1, std::memory_order_relaxed);
+
+    lastCallbackTicks = now;
+    numCallbacks.fetch_add(1, std::memory_order_relaxed);
+
+    const PerformanceMonitor::ScopedBlockTimer blockTimer(callbackMonitor, numSamples);
+    player.audioDeviceIOCallbackWithContext(inputChannelData, numInputChannels, outputChannelData, numOutputChannels,
+                                            numSamples, context);
+}
+
+void HeadlessEngine::audioDeviceAboutToStart(juce::AudioIODevice* device)
+{
+    const auto sampleRate = device->getCurrentSampleRate();
+    const auto period = device->getCurrentBufferSizeSamples() / juce::jmax(1.0, sampleRate);
+
+    callbackMonitor.prepare(sampleRate);
+    callbackMonitor.resetStatistics();
+
+    audioThreadPrepared = false;
+    lastCallbackTicks = 0;
+    numCallbacks = 0;
+    lateCallbacks = 0;
+    lateCallbackTicks = (juce::int64) (1.5 * period * (double) juce::Time::getHighResolutionTicksPerSecond());
+
+    player.audioDeviceAboutToStart(device);
+}
+
+void HeadlessEngine::audioDeviceStopped()
+{
+    player.audioDeviceStopped();
+}
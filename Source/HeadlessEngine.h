@@ -0,0 +1,126 @@
+#pragma once
+
+#include "PluginProcessor.h"
+#include "DummyAudioDevice.h"
+#include <juce_audio_utils/juce_audio_utils.h>
+
+//==============================================================================
+/**
+ * HeadlessEngine runs SimpleGainProcessor straight on an audio device, with no
+ * editor or window. It is the standalone app's --headless mode.
+ *
+ * Before the device opens it locks the process's memory and stops malloc
+ * giving pages back to the OS, so nothing the audio thread touches can page
+ * fault later. The first callback raises the audio thread to SCHED_FIFO
+ * (unless the driver already runs it real-time, as JACK does) and touches its
+ * stack. Every device callback is timed against the buffer period with a
+ * PerformanceMonitor, next to the device's own xrun count and a count of
+ * callbacks that arrived late.
+ *
+ * The real-time hardening is Linux only; elsewhere the engine runs without it.
+ */
+class HeadlessEngine : private juce::AudioIODeviceCallback
+{
+public:
+    struct Options
+    {
+        juce::String deviceType;            // empty for the first available type (ALSA on Linux)
+        juce::String inputDevice;           // empty for the type's default
+        juce::String outputDevice;
+        double sampleRate = 0.0;            // 0 for the device's default
+        int bufferSize = 0;
+        int numInputChannels = 2;
+        int numOutputChannels = 2;
+        int realtimePriority = 80;          // SCHED_FIFO priority, 0 to leave the scheduling alone
+        bool lockMemory = true;
+        juce::File stateFile;               // a state saved by the plugin, loaded before starting
+        int program = -1;
+    };
+
+    enum class RealtimeState
+    {
+        notAttempted,
+        raised,             // moved to SCHED_FIFO at the requested priority
+        alreadyRealtime,    // the driver's thread was already SCHED_FIFO or SCHED_RR
+        failed              // usually EPERM: see RLIMIT_RTPRIO
+    };
+
+    struct Status
+    {
+        juce::String deviceType, deviceName;
+        double sampleRate = 0.0;
+        int bufferSize = 0;
+        int latencySamples = 0;
+        double runningSeconds = 0.0;
+
+        juce::uint64 numCallbacks = 0;
+        int deviceXRuns = -1;               // -1 if the device doesn't report them
+        juce::uint64 lateCallbacks = 0;     // more than 1.5 periods after the previous one
+
+        PerformanceMonitor::Statistics callbackTiming;   // the whole device callback
+        PerformanceMonitor::Statistics processorTiming;  // processBlock alone
+
+        RealtimeState realtime = RealtimeState::notAttempted;
+        int realtimePriority = 0;
+        int realtimeError = 0;
+        bool memoryLocked = false;
+        juce::String memoryLockError;
+
+        juce::String toString() const;
+        juce::String toJson() const;
+    };
+
+    //==============================================================================
+    HeadlessEngine();
+    ~HeadlessEngine() override;
+
+    // Returns an error message, or an empty string once the device is running
+    juce::String start(const Options& options);
+    void stop();
+
+    bool isRunning() const noexcept     { return processor != nullptr; }
+
+    // Drains the timing records; call regularly from the message thread
+    Status getStatus();
+
+    SimpleGainProcessor* getProcessor() noexcept    { return processor.get(); }
+
+    // Every device type with its input and output devices, for --list-devices
+    juce::String describeDevices();
+
+private:
+    //==============================================================================
+    void audioDeviceIOCallbackWithContext(const float* const* inputChannelData, int numInputChannels,
+                                          float* const* outputChannelData, int numOutputChannels,
+                                          int numSamples, const juce::AudioIODeviceCallbackContext& context) override;
+    void audioDeviceAboutToStart(juce::AudioIODevice* device) override;
+    void audioDeviceStopped() override;
+
+    void lockMemory();
+    void prepareAudioThread() noexcept;
+
+    //==============================================================================
+    Options options;
+    juce::AudioDeviceManager deviceManager;
+    juce::AudioProcessorPlayer player;
+    std::unique_ptr<SimpleGainProcessor> processor;
+
+    PerformanceMonitor callbackMonitor;
+    juce::int64 startTicks = 0;
+
+    // Audio thread
+    bool audioThreadPrepared = false;
+    juce::int64 lastCallbackTicks = 0;
+    juce::int64 lateCallbackTicks = 0;
+
+    std::atomic<juce::uint64> numCallbacks { 0 };
+    std::atomic<juce::uint64> lateCallbacks { 0 };
+    std::atomic<RealtimeState> realtimeState { RealtimeState::notAttempted };
+    std::atomic<int> realtimePriority { 0 };
+    std::atomic<int> realtimeError { 0 };
+
+    bool memoryLocked = false;
+    juce::String memoryLockError;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HeadlessEngine)
+};
@@ -0,0 +1,141 @@
+#include "KernelDispatch.h"
+
+#if JUCE_INTEL && JUCE_MSVC
+ #include <intrin.h>
+#endif
+
+//==============================================================================
+namespace KernelDispatch
+{
+    // Defined in KernelsBaseline.cpp, KernelsAvx2.cpp and KernelsAvx512.cpp
+    extern const KernelTable baselineKernels;
+
+   #if SIMPLEGAIN_AVX2_KERNELS
+    extern const KernelTable avx2Kernels;
+   #endif
+
+   #if SIMPLEGAIN_AVX512_KERNELS
+    extern const KernelTable avx512Kernels;
+   #endif
+
+    namespace
+    {
+        const KernelTable* getCompiledKernels(Variant variant) noexcept
+        {
+            switch (variant)
+            {
+                case Variant::baseline:    return &baselineKernels;
+               #if SIMPLEGAIN_AVX2_KERNELS
+                case Variant::avx2:        return &avx2Kernels;
+               #endif
+               #if SIMPLEGAIN_AVX512_KERNELS
+                case Variant::avx512:      return &avx512Kernels;
+               #endif
+                default:                   return nullptr;
+            }
+        }
+
+       #if JUCE_INTEL && JUCE_MSVC
+        // CPUID alone isn't enough: the OS must also save the wider registers on a
+        // context switch, which XGETBV reports
+        bool cpuSupports(Variant variant) noexcept
+        {
+            int info[4] = {};
+            __cpuid(info, 0);
+
+            if (info[0] < 7)
+                return false;
+
+            __cpuid(info, 1);
+            const auto hasOsxsave = (info[2] & (1 << 27)) != 0;
+
+            if (! hasOsxsave)
+                return false;
+
+            const auto savedState = _xgetbv(0);
+            const auto savesYmm = (savedState & 0x06) == 0x06;
+            const auto savesZmm = (savedState & 0xe6) == 0xe6;
+
+            __cpuidex(info, 7, 0);
+            const auto leaf7 = (unsigned int) info[1];
+
+            if (variant == Variant::avx2)
+                return savesYmm && (leaf7 & (1u << 5)) != 0;
+
+            // F, DQ, BW and VL
+            constexpr auto avx512Bits = (1u << 16) | (1u << 17) | (1u << 30) | (1u << 31);
+            return savesZmm && (leaf7 & avx512Bits) == avx512Bits;
+        }
+       #elif JUCE_INTEL
+        // These builtins check the OS's saved register state as well as CPUID
+        bool cpuSupports(Variant variant) noexcept
+        {
+            __builtin_cpu_init();
+
+            if (variant == Variant::avx2)
+                return __builtin_cpu_supports("avx2");
+
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")
+                && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl");
+        }
+       #else
+        bool cpuSupports(Variant) noexcept
+        {
+            return false;
+        }
+       #endif
+
+        const KernelTable& selectKernels() noexcept
+        {
+           #if SIMPLEGAIN_PINNED_KERNELS >= 0
+            // Pinned for testing; a CPU that can't run the pinned variant gets the baseline
+            if (auto* pinned = getKernels((Variant) SIMPLEGAIN_PINNED_KERNELS))
+                return *pinned;
+
+            jassertfalse;
+            return baselineKernels;
+           #else
+            for (auto variant : { Variant::avx512, Variant::avx2 })
+                if (auto* kernels = getKernels(variant))
+                    return *kernels;
+
+            return baselineKernels;
+           #endif
+        }
+    }
+
+    //==============================================================================
+    const KernelTable& getKernels() noexcept
+    {
+        static const KernelTable& selected = selectKernels();
+        return selected;
+    }
+
+    const KernelTable* getKernels(Variant variant) noexcept
+    {
+        return isSupported(variant) ? getCompiledKernels(variant) : nullptr;
+    }
+
+    bool isSupported(Variant variant) noexcept
+    {
+        if (getCompiledKernels(variant) == nullptr)
+            return false;
+
+        return variant == Variant::baseline || cpuSupports(variant);
+    }
+
+    const char* getName(Variant variant) noexcept
+    {
+        switch (variant)
+        {
+           #if JUCE_INTEL && JUCE_64BIT
+            case Variant::baseline:    return "sse2";
+           #else
+            case Variant::baseline:    return "baseline";
+           #endif
+            case Variant::avx2:        return "avx2";
+            case Variant::avx512:      return "avx512";
+            default:                   return "unknown";
+        }
+    }
+}
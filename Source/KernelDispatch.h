@@ -0,0 +1,96 @@
+#pragma once
+
+#include "GainKernels.h"
+
+// Which kernel variants the build compiled in, set by CMake on x86 builds
+#ifndef SIMPLEGAIN_AVX2_KERNELS
+ #define SIMPLEGAIN_AVX2_KERNELS 0
+#endif
+
+#ifndef SIMPLEGAIN_AVX512_KERNELS
+ #define SIMPLEGAIN_AVX512_KERNELS 0
+#endif
+
+// A Variant index to use instead of the CPU check, or -1 to choose at runtime
+#ifndef SIMPLEGAIN_PINNED_KERNELS
+ #define SIMPLEGAIN_PINNED_KERNELS -1
+#endif
+
+//==============================================================================
+/**
+ * KernelDispatch picks the build of the GainKernels loops that suits the CPU.
+ *
+ * The loops are compiled once per instruction set (see KernelVariant.h): the
+ * baseline the rest of the plugin is built for (SSE2 on x86-64), AVX2, and
+ * AVX-512. The first call to getKernels() checks the CPU and the OS's saved
+ * register state once and returns the widest variant that can run, or the
+ * variant pinned with SIMPLEGAIN_KERNEL_VARIANT if the CPU supports it.
+ *
+ * Every variant does the same arithmetic in the same order without fused
+ * multiply-adds, so their output is bit-identical; only the speed differs.
+ */
+namespace KernelDispatch
+{
+    enum class Variant
+    {
+        baseline,
+        avx2,
+        avx512,
+        numVariants
+    };
+
+    // Entry points used by SimpleGainProcessor and MultiStreamEngine, for one sample type
+    template <typename SampleType>
+    struct KernelSet
+    {
+        using LevelAccumulator = GainKernels::LevelAccumulator;
+        using OutputStage = GainKernels::OutputStage;
+        using StreamState = GainKernels::StreamState;
+
+        void (*applyGain)(SampleType* const* channels, int numChannels, int startSample, SampleType gain, int numSamples,
+                          LevelAccumulator* inputLevels, LevelAccumulator* outputLevels, const OutputStage* outputStage) noexcept;
+
+        void (*applyEnvelope)(SampleType* const* channels, int numChannels, int startSample, const SampleType* envelope,
+                              int numSamples, LevelAccumulator* inputLevels, LevelAccumulator* outputLevels,
+                              const OutputStage* outputStage) noexcept;
+
+        void (*applyStereoEnvelopes)(SampleType* const* channels, int startSample, const SampleType* first,
+                                     const SampleType* second, int numSamples, bool midSide, LevelAccumulator* inputLevels,
+                                     LevelAccumulator* outputLevels, const OutputStage* outputStage) noexcept;
+
+        void (*measureLevels)(SampleType* const* channels, int numChannels, int startSample, int numSamples,
+                              LevelAccumulator& levels) noexcept;
+
+        bool (*isSilent)(const SampleType* const* channels, int numChannels, int startSample, int numSamples,
+                         SampleType threshold) noexcept;
+
+        void (*processStreams)(SampleType* const* streams, const StreamState& state, int firstStream, int numStreams,
+                               int startSample, int numSamples) noexcept;
+    };
+
+    struct KernelTable
+    {
+        Variant variant;
+        KernelSet<float> floatKernels;
+        KernelSet<double> doubleKernels;
+
+        template <typename SampleType>
+        const KernelSet<SampleType>& get() const noexcept
+        {
+            if constexpr (std::is_same_v<SampleType, float>)
+                return floatKernels;
+            else
+                return doubleKernels;
+        }
+    };
+
+    //==============================================================================
+    // The variant chosen for this process; the choice is made on the first call
+    const KernelTable& getKernels() noexcept;
+
+    // A specific variant, or nullptr if it wasn't compiled in or this CPU can't run it
+    const KernelTable* getKernels(Variant variant) noexcept;
+
+    bool isSupported(Variant variant) noexcept;
+    const char* getName(Variant variant) noexcept;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+// Included once by each Kernels*.cpp, after it defines SIMPLEGAIN_KERNEL_ISA and
+// SIMPLEGAIN_KERNEL_TABLE. That file is compiled with the instruction set's flags
+// (see CMakeLists.txt), so everything it instantiates must come from the ISA's
+// own namespace: an inline function shared with the rest of the program, such as
+// juce::jmax<double>, could be emitted here with wide instructions and then picked
+// by the linker for every caller, including those running on older CPUs.
+
+#ifndef SIMPLEGAIN_KERNEL_TABLE
+ #error "Define SIMPLEGAIN_KERNEL_ISA and SIMPLEGAIN_KERNEL_TABLE before including KernelVariant.h"
+#endif
+
+#include "KernelDispatch.h"
+
+namespace KernelDispatch
+{
+    inline namespace SIMPLEGAIN_KERNEL_ISA
+    {
+    // Wrappers with a fixed signature, so the table can hold plain function pointers
+    template <typename SampleType>
+    constexpr KernelSet<SampleType> makeKernelSet() noexcept
+    {
+        return {
+            [](SampleType* const* channels, int numChannels, int startSample, SampleType gain, int numSamples,
+               GainKernels::LevelAccumulator* inputLevels, GainKernels::LevelAccumulator* outputLevels,
+               const GainKernels::OutputStage* outputStage) noexcept
+            {
+                GainKernels::applyGain(channels, numChannels, startSample, gain, numSamples,
+                                       inputLevels, outputLevels, outputStage);
+            },
+            [](SampleType* const* channels, int numChannels, int startSample, const SampleType* envelope, int numSamples,
+               GainKernels::LevelAccumulator* inputLevels, GainKernels::LevelAccumulator* outputLevels,
+               const GainKernels::OutputStage* outputStage) noexcept
+            {
+                GainKernels::applyEnvelope(channels, numChannels, startSample, envelope, numSamples,
+                                           inputLevels, outputLevels, outputStage);
+            },
+            [](SampleType* const* channels, int startSample, const SampleType* first, const SampleType* second,
+               int numSamples, bool midSide, GainKernels::LevelAccumulator* inputLevels,
+               GainKernels::LevelAccumulator* outputLevels, const GainKernels::OutputStage* outputStage) noexcept
+            {
+                GainKernels::applyStereoEnvelopes(channels, startSample, first, second, numSamples, midSide,
+                                                  inputLevels, outputLevels, outputStage);
+            },
+            [](SampleType* const* channels, int numChannels, int startSample, int numSamples,
+               GainKernels::LevelAccumulator& levels) noexcept
+            {
+                GainKernels::measureLevels(channels, numChannels, startSample, numSamples, levels);
+            },
+            [](const SampleType* const* channels, int numChannels, int startSample, int numSamples,
+               SampleType threshold) noexcept
+            {
+                return GainKernels::isSilent(channels, numChannels, startSample, numSamples, threshold);
+            },
+            [](SampleType* const* streams, const GainKernels::StreamState& state, int firstStream, int numStreams,
+               int startSample, int numSamples) noexcept
+            {
+                GainKernels::processStreams(streams, state, firstStream, numStreams, startSample, numSamples);
+            }
+        };
+    }
+    } // inline namespace SIMPLEGAIN_KERNEL_ISA
+
+    extern const KernelTable SIMPLEGAIN_KERNEL_TABLE;
+
+    // Constant-initialised, so it is ready before any static constructor can ask for it
+    constexpr KernelTable SIMPLEGAIN_KERNEL_TABLE { Variant::SIMPLEGAIN_KERNEL_ISA,
+                                                    makeKernelSet<float>(),
+                                                    makeKernelSet<double>() };
+}
@@ -0,0 +1,4 @@
+// Built with AVX2 code generation; only selected on CPUs that support it
+#define SIMPLEGAIN_KERNEL_ISA avx2
+#define SIMPLEGAIN_KERNEL_TABLE avx2Kernels
+#include "KernelVariant.h"
@@ -0,0 +1,4 @@
+// Built with AVX-512 (F, BW, DQ, VL) code generation; only selected on CPUs that support it
+#define SIMPLEGAIN_KERNEL_ISA avx512
+#define SIMPLEGAIN_KERNEL_TABLE avx512Kernels
+#include "KernelVariant.h"
@@ -0,0 +1,4 @@
+// The kernels built with the same flags as the rest of the plugin
+#define SIMPLEGAIN_KERNEL_ISA baseline
+#define SIMPLEGAIN_KERNEL_TABLE baselineKernels
+#include "KernelVariant.h"
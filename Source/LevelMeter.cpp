@@ -0,0 +1,59 @@
+#include "LevelMeter.h"
+
+//==============================================================================
+namespace
+{
+    // Smallest change, in dB, worth a repaint
+    constexpr float repaintThreshold = 0.25f;
+}
+
+LevelMeter::LevelMeter()
+{
+    setOpaque(true);
+}
+
+void LevelMeter::setLevels(float newPeakDecibels, float newRmsDecibels)
+{
+    newPeakDecibels = juce::jlimit(minDecibels, maxDecibels, newPeakDecibels);
+    newRmsDecibels = juce::jlimit(minDecibels, maxDecibels, newRmsDecibels);
+
+    if (std::abs(newPeakDecibels - peakDecibels) < repaintThreshold
+        && std::abs(newRmsDecibels - rmsDecibels) < repaintThreshold)
+        return;
+
+    peakDecibels = newPeakDecibels;
+    rmsDecibels = newRmsDecibels;
+    repaint();
+}
+
+void LevelMeter::setBarColour(juce::Colour newColour)
+{
+    barColour = newColour;
+    repaint();
+}
+
+float LevelMeter::decibelsToProportion(float decibels) const noexcept
+{
+    return (decibels - minDecibels) / (maxDecibels - minDecibels);
+}
+
+//==============================================================================
+void LevelMeter::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    g.fillAll(juce::Colour(20, 20, 20));
+
+    // RMS bar, turning red above 0 dBFS
+    const auto rmsWidth = bounds.getWidth() * decibelsToProportion(rmsDecibels);
+    g.setColour(rmsDecibels > 0.0f ? juce::Colours::red.withAlpha(0.8f) : barColour);
+    g.fillRect(bounds.withWidth(rmsWidth));
+
+    // 0 dBFS mark
+    g.setColour(juce::Colours::white.withAlpha(0.3f));
+    g.fillRect(bounds.getWidth() * decibelsToProportion(0.0f), bounds.getY(), 1.0f, bounds.getHeight());
+
+    // Peak marker
+    g.setColour(peakDecibels > 0.0f ? juce::Colours::red : juce::Colours::white);
+    g.fillRect(juce::jmax(0.0f, bounds.getWidth() * decibelsToProportion(peakDecibels) - 2.0f),
+               bounds.getY(), 2.0f, bounds.getHeight());
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+//==============================================================================
+/**
+ * LevelMeter is a horizontal bar showing an RMS level with a peak marker.
+ *
+ * It is opaque and only repaints itself when the displayed levels move by a
+ * visible amount, so meter updates never repaint the rest of the editor.
+ */
+class LevelMeter : public juce::Component
+{
+public:
+    //==============================================================================
+    LevelMeter();
+
+    // Levels in dB; the range shown is minDecibels..maxDecibels
+    void setLevels(float newPeakDecibels, float newRmsDecibels);
+    void setBarColour(juce::Colour newColour);
+
+    //==============================================================================
+    void paint(juce::Graphics&) override;
+
+    static constexpr float minDecibels = -60.0f;
+    static constexpr float maxDecibels = 12.0f;
+
+private:
+    float decibelsToProportion(float decibels) const noexcept;
+
+    float peakDecibels = minDecibels;
+    float rmsDecibels = minDecibels;
+    juce::Colour barColour = juce::Colour(42, 128, 185);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeter)
+};
@@ -0,0 +1,316 @@
+#include "ModulationLfo.h"
+
+//==============================================================================
+namespace
+{
+    constexpr int sineTableSize = 2048;
+
+    inline float lookupSine(const float* table, double phase) noexcept
+    {
+        const auto position = phase * sineTableSize;
+        const auto whole = (int) position;
+        const auto fraction = (float) (position - whole);
+
+        // A phase that rounded up to exactly 1 reads the start of the next cycle, not past the guard point
+        const auto index = whole & (sineTableSize - 1);
+        return table[index] + fraction * (table[index + 1] - table[index]);
+    }
+
+    // The lagging output's phase, back in [0, 1). Adding 1 to a tiny negative difference
+    // can round to exactly 1, so that case wraps too.
+    inline double wrapLaggingPhase(double laggingPhase) noexcept
+    {
+        laggingPhase += laggingPhase < 0.0 ? 1.0 : 0.0;
+        return laggingPhase >= 1.0 ? laggingPhase - 1.0 : laggingPhase;
+    }
+
+    // The non-sine shapes all start at 0 and rise, like the sine
+    inline float triangleAt(double phase) noexcept
+    {
+        auto shifted = phase + 0.25;
+        shifted -= shifted >= 1.0 ? 1.0 : 0.0;
+        return (float) (1.0 - 4.0 * std::abs(shifted - 0.5));
+    }
+
+    inline float sawAt(double phase) noexcept
+    {
+        return (float) (phase < 0.5 ? 2.0 * phase : 2.0 * phase - 2.0);
+    }
+
+    inline float squareAt(double phase) noexcept
+    {
+        return phase < 0.5 ? 1.0f : -1.0f;
+    }
+}
+
+//==============================================================================
+// One sine cycle plus a guard point, so interpolation never needs to wrap
+struct ModulationLfo::SineTable
+{
+    SineTable()
+    {
+        for (int i = 0; i <= sineTableSize; ++i)
+            values[i] = (float) std::sin(juce::MathConstants<double>::twoPi * i / sineTableSize);
+    }
+
+    float values[sineTableSize + 1];
+};
+
+//==============================================================================
+// The table is built by the first instance, before any audio thread can need it
+ModulationLfo::ModulationLfo() = default;
+ModulationLfo::~ModulationLfo() = default;
+
+void ModulationLfo::prepare(double newSampleRate)
+{
+    jassert(newSampleRate > 0.0);
+    sampleRate = newSampleRate;
+
+    setFrequency(frequency);
+    reset();
+}
+
+void ModulationLfo::reset() noexcept
+{
+    phase = 0.0;
+    controlCountdown = 0;
+    controlValue = 0.0f;
+    controlStep = 0.0f;
+    laggingControlValue = 0.0f;
+    laggingControlStep = 0.0f;
+    heldValue = random.nextFloat() * 2.0f - 1.0f;
+    previousHeldValue = heldValue;
+}
+
+void ModulationLfo::setShape(Shape newShape) noexcept
+{
+    shape = newShape;
+}
+
+void ModulationLfo::setFrequency(float newFrequency) noexcept
+{
+    frequency = newFrequency;
+
+    // Audio-rate frequencies are capped at Nyquist, so the phase never wraps more than once per sample
+    phaseIncrement = juce::jmin(0.5, frequency / (sampleRate * oversamplingFactor));
+}
+
+void ModulationLfo::setOversamplingFactor(int factor) noexcept
+{
+    const auto newFactor = juce::jmax(1, factor);
+
+    if (newFactor != oversamplingFactor)
+    {
+        oversamplingFactor = newFactor;
+        setFrequency(frequency);
+    }
+}
+
+void ModulationLfo::setControlRateInterval(int numSamples) noexcept
+{
+    const auto newInterval = juce::jmax(1, numSamples);
+
+    if (newInterval != controlInterval)
+    {
+        // Finish the current segment at the right phase before switching
+        advance(controlCountdown);
+        controlInterval = newInterval;
+    }
+}
+
+void ModulationLfo::setPhaseOffset(double newOffset) noexcept
+{
+    phaseOffset = juce::jlimit(0.0, 0.5, newOffset);
+}
+
+//==============================================================================
+float ModulationLfo::evaluate(double phaseToUse) const noexcept
+{
+    switch (shape)
+    {
+        case Shape::sine:          return lookupSine(sineTable->values, phaseToUse);
+        case Shape::triangle:      return triangleAt(phaseToUse);
+        case Shape::saw:           return sawAt(phaseToUse);
+        case Shape::square:        return squareAt(phaseToUse);
+        case Shape::sampleAndHold: return heldValue;
+    }
+
+    return 0.0f;
+}
+
+float ModulationLfo::evaluateLagging(double phaseToUse) const noexcept
+{
+    // Sample and hold lags by keeping the previous step until its own phase wraps
+    if (shape == Shape::sampleAndHold)
+        return phaseToUse >= phaseOffset ? heldValue : previousHeldValue;
+
+    return evaluate(wrapLaggingPhase(phaseToUse - phaseOffset));
+}
+
+void ModulationLfo::advancePhase(double delta) noexcept
+{
+    phase += delta;
+
+    if (phase >= 1.0)
+    {
+        phase -= std::floor(phase);
+
+        // A new random step every cycle
+        previousHeldValue = heldValue;
+        heldValue = random.nextFloat() * 2.0f - 1.0f;
+    }
+}
+
+float ModulationLfo::getNextSample() noexcept
+{
+    float laggingValue;
+    return nextSample<false>(laggingValue);
+}
+
+template <bool withLagging>
+float ModulationLfo::nextSample(float& laggingValue) noexcept
+{
+    if (controlInterval <= 1)
+    {
+        const auto value = evaluate(phase);
+
+        if constexpr (withLagging)
+            laggingValue = evaluateLagging(phase);
+
+        advancePhase(phaseIncrement);
+        return value;
+    }
+
+    if (controlCountdown == 0)
+    {
+        // Evaluate both ends of the next segment; the phase is left at its end.
+        // The lagging segment is cheap at this rate, so it is always kept up to date.
+        controlValue = evaluate(phase);
+        laggingControlValue = evaluateLagging(phase);
+        advancePhase(phaseIncrement * controlInterval);
+        controlStep = (evaluate(phase) - controlValue) / (float) controlInterval;
+        laggingControlStep = (evaluateLagging(phase) - laggingControlValue) / (float) controlInterval;
+        controlCountdown = controlInterval;
+    }
+
+    const auto value = controlValue;
+    controlValue += controlStep;
+
+    if constexpr (withLagging)
+        laggingValue = laggingControlValue;
+
+    laggingControlValue += laggingControlStep;
+    --controlCountdown;
+    return value;
+}
+
+void ModulationLfo::advance(int numSamples) noexcept
+{
+    if (controlInterval > 1)
+    {
+        // The phase already sits at the end of the current segment
+        const auto inSegment = juce::jmin(numSamples, controlCountdown);
+        controlValue += controlStep * (float) inSegment;
+        laggingControlValue += laggingControlStep * (float) inSegment;
+        controlCountdown -= inSegment;
+        numSamples -= inSegment;
+    }
+
+    if (numSamples > 0)
+        advancePhase(phaseIncrement * numSamples);
+}
+
+//==============================================================================
+template <bool withLagging, typename SampleType, typename ShapeFunction>
+void ModulationLfo::processShape(SampleType* destination, SampleType* laggingDestination, int numSamples,
+                                 ShapeFunction&& shapeFunction) noexcept
+{
+    auto localPhase = phase;
+    auto laggingPhase = wrapLaggingPhase(phase - phaseOffset);
+    const auto increment = phaseIncrement;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        destination[i] = (SampleType) shapeFunction(localPhase);
+        localPhase += increment;
+        localPhase -= localPhase >= 1.0 ? 1.0 : 0.0;
+
+        if constexpr (withLagging)
+        {
+            laggingDestination[i] = (SampleType) shapeFunction(laggingPhase);
+            laggingPhase += increment;
+            laggingPhase -= laggingPhase >= 1.0 ? 1.0 : 0.0;
+        }
+    }
+
+    phase = localPhase;
+}
+
+template <typename SampleType>
+void ModulationLfo::render(SampleType* destination, SampleType* laggingDestination, int numSamples) noexcept
+{
+    // Control-rate and sample-and-hold need the per-sample bookkeeping
+    if (controlInterval > 1 || shape == Shape::sampleAndHold)
+    {
+        float laggingValue;
+
+        if (laggingDestination == nullptr)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = (SampleType) nextSample<false>(laggingValue);
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                destination[i] = (SampleType) nextSample<true>(laggingValue);
+                laggingDestination[i] = (SampleType) laggingValue;
+            }
+        }
+
+        return;
+    }
+
+    auto processWith = [&](auto&& shapeFunction)
+    {
+        if (laggingDestination == nullptr)
+            processShape<false>(destination, laggingDestination, numSamples, shapeFunction);
+        else
+            processShape<true>(destination, laggingDestination, numSamples, shapeFunction);
+    };
+
+    switch (shape)
+    {
+        case Shape::sine:
+        {
+            const auto* table = sineTable->values;
+            processWith([table](double p) { return lookupSine(table, p); });
+            break;
+        }
+
+        case Shape::triangle:      processWith(triangleAt); break;
+        case Shape::saw:           processWith(sawAt); break;
+        case Shape::square:        processWith(squareAt); break;
+        case Shape::sampleAndHold: break;
+    }
+}
+
+void ModulationLfo::process(float* destination, int numSamples) noexcept
+{
+    render<float>(destination, nullptr, numSamples);
+}
+
+void ModulationLfo::process(double* destination, int numSamples) noexcept
+{
+    render<double>(destination, nullptr, numSamples);
+}
+
+void ModulationLfo::process(float* destination, float* laggingDestination, int numSamples) noexcept
+{
+    render(destination, laggingDestination, numSamples);
+}
+
+void ModulationLfo::process(double* destination, double* laggingDestination, int numSamples) noexcept
+{
+    render(destination, laggingDestination, numSamples);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+ * ModulationLfo is the low-frequency oscillator behind the gain modulation.
+ *
+ * The sine is read from a lookup table that is shared by every instance in the
+ * process and freed with the last one; the other shapes are computed directly
+ * from the phase. In control-rate mode the shape is only evaluated every few
+ * samples and linearly interpolated in between.
+ *
+ * For stereo modulation it can also render a second, lagging output from the
+ * same phase accumulator, so the two never drift apart.
+ */
+class ModulationLfo
+{
+public:
+    //==============================================================================
+    enum class Shape
+    {
+        sine,
+        triangle,
+        saw,
+        square,
+        sampleAndHold
+    };
+
+    //==============================================================================
+    ModulationLfo();
+    ~ModulationLfo();
+
+    //==============================================================================
+    void prepare(double newSampleRate);
+    void reset() noexcept;
+
+    void setShape(Shape newShape) noexcept;
+    void setFrequency(float newFrequency) noexcept;
+
+    // Runs the LFO at factor times the prepared sample rate, for oversampled processing
+    void setOversamplingFactor(int factor) noexcept;
+
+    // 1 evaluates every sample, larger values evaluate every N samples and interpolate
+    void setControlRateInterval(int numSamples) noexcept;
+
+    // How far the lagging output trails the main one, in cycles (0..0.5)
+    void setPhaseOffset(double newOffset) noexcept;
+
+    //==============================================================================
+    // Writes numSamples values in the range -1..1
+    void process(float* destination, int numSamples) noexcept;
+    void process(double* destination, int numSamples) noexcept;
+
+    // Writes the main output and the lagging output side by side
+    void process(float* destination, float* laggingDestination, int numSamples) noexcept;
+    void process(double* destination, double* laggingDestination, int numSamples) noexcept;
+
+    float getNextSample() noexcept;
+
+    // Moves on as if numSamples had been rendered, without rendering them
+    void advance(int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    struct SineTable;
+
+    float evaluate(double phaseToUse) const noexcept;
+    float evaluateLagging(double phaseToUse) const noexcept;
+    void advancePhase(double delta) noexcept;
+
+    template <bool withLagging>
+    float nextSample(float& laggingValue) noexcept;
+
+    template <typename SampleType>
+    void render(SampleType* destination, SampleType* laggingDestination, int numSamples) noexcept;
+
+    template <bool withLagging, typename SampleType, typename ShapeFunction>
+    void processShape(SampleType* destination, SampleType* laggingDestination, int numSamples,
+                      ShapeFunction&& shapeFunction) noexcept;
+
+    //==============================================================================
+    juce::SharedResourcePointer<SineTable> sineTable;
+
+    Shape shape = Shape::sine;
+    double sampleRate = 44100.0;
+    int oversamplingFactor = 1;
+    float frequency = 1.0f;
+    double phase = 0.0;             // 0..1
+    double phaseIncrement = 0.0;    // cycles per sample
+    double phaseOffset = 0.0;       // lag of the second output, in cycles
+
+    int controlInterval = 1;
+    int controlCountdown = 0;
+    float controlValue = 0.0f;
+    float controlStep = 0.0f;
+    float laggingControlValue = 0.0f;
+    float laggingControlStep = 0.0f;
+
+    float heldValue = 0.0f;
+    float previousHeldValue = 0.0f;     // what the lagging output holds until it reaches the new step
+    juce::Random random;
+
+    JUCE_LEAK_DETECTOR(ModulationLfo)
+};
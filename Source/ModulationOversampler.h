@@ -0,0 +1,262 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <memory>
+
+//==============================================================================
+/**
+ * ModulationOversampler runs audio-rate modulation at 2x, 4x or 8x the host
+ * rate, so the sidebands it creates don't fold back below Nyquist.
+ *
+ * The filters are JUCE's polyphase half-band FIR cascade with integer latency,
+ * which gives an exact latency to report to the host. While the modulation is
+ * slow enough not to need oversampling, the processed signal goes through a
+ * plain delay of the same length instead, so the reported latency only depends
+ * on the chosen factor.
+ *
+ * Switching between the two paths doesn't click: on the way in, the filters
+ * are primed with the recent output history; on the way out, the host-rate
+ * output keeps going through the filters until the delay line has caught up.
+ */
+template <typename SampleType>
+class ModulationOversampler
+{
+public:
+    // Choice 0 is off, then 2x, 4x and 8x
+    static constexpr int numChoices = 4;
+    static constexpr int maxFactor = 1 << (numChoices - 1);
+
+    //==============================================================================
+    void prepare(int newNumChannels, int maxBlockSize)
+    {
+        numChannels = juce::jmax(1, newNumChannels);
+        maxSamplesPerBlock = juce::jmax(1, maxBlockSize);
+        auto maxLatency = 0;
+
+        for (int index = 1; index < numChoices; ++index)
+        {
+            auto& stage = stages[(size_t) index];
+            stage = std::make_unique<juce::dsp::Oversampling<SampleType>>((size_t) numChannels, (size_t) index,
+                                                                          juce::dsp::Oversampling<SampleType>::filterHalfBandFIREquiripple,
+                                                                          true, true);
+            stage->initProcessing((size_t) maxSamplesPerBlock);
+
+            latencies[(size_t) index] = juce::roundToInt(stage->getLatencyInSamples());
+            maxLatency = juce::jmax(maxLatency, latencies[(size_t) index]);
+        }
+
+        // Priming reads back twice the latency, which covers both filter halves
+        historySize = juce::nextPowerOfTwo(juce::jmax(2, 2 * maxLatency));
+        history.setSize(numChannels, historySize);
+        primingBuffer.setSize(numChannels, maxSamplesPerBlock);
+        reset();
+    }
+
+    void release()
+    {
+        for (auto& stage : stages)
+            stage.reset();
+
+        history.setSize(0, 0);
+        primingBuffer.setSize(0, 0);
+        numChannels = 0;
+    }
+
+    void reset() noexcept
+    {
+        for (auto& stage : stages)
+            if (stage != nullptr)
+                stage->reset();
+
+        history.clear();
+        writePosition = 0;
+        drainRemaining = 0;
+        state = State::bypassed;
+    }
+
+    //==============================================================================
+    void setChoice(int newChoice) noexcept
+    {
+        newChoice = juce::jlimit(0, numChoices - 1, newChoice);
+
+        // The latency changes, so the delay history no longer lines up
+        if (newChoice != choice)
+        {
+            choice = newChoice;
+            reset();
+        }
+    }
+
+    bool isAvailable() const noexcept       { return choice > 0 && stages[(size_t) choice] != nullptr; }
+    bool isEngaged() const noexcept         { return state == State::engaged; }
+    int getFactor() const noexcept          { return 1 << choice; }
+
+    int getLatencySamples() const noexcept  { return getLatencySamples(choice); }
+
+    int getLatencySamples(int choiceToUse) const noexcept
+    {
+        return latencies[(size_t) juce::jlimit(0, numChoices - 1, choiceToUse)];
+    }
+
+    // How long the output keeps going after the input stops: the linear-phase filters
+    // ring for twice their latency, and that also flushes the delay history
+    int getTailSamples() const noexcept     { return 2 * getLatencySamples(); }
+
+    //==============================================================================
+    // Oversampled path: modulate the returned block, then call processSamplesDown
+    juce::dsp::AudioBlock<SampleType> processSamplesUp(SampleType* const* channels, int numChannelsToUse,
+                                                       int startSample, int numSamples) noexcept
+    {
+        jassert(isAvailable());
+
+        if (state == State::bypassed)
+            prime();
+
+        state = State::engaged;
+        return stages[(size_t) choice]->processSamplesUp(makeBlock(channels, numChannelsToUse, startSample, numSamples));
+    }
+
+    void processSamplesDown(SampleType* const* channels, int numChannelsToUse, int startSample, int numSamples) noexcept
+    {
+        auto block = makeBlock(channels, numChannelsToUse, startSample, numSamples);
+        stages[(size_t) choice]->processSamplesDown(block);
+    }
+
+    // Host-rate path: the block has already been processed and only needs the latency added
+    void processBypassed(SampleType* const* channels, int numChannelsToUse, int startSample, int numSamples) noexcept
+    {
+        if (state == State::bypassed)
+        {
+            delay(channels, numChannelsToUse, startSample, numSamples);
+            return;
+        }
+
+        if (state == State::engaged)
+        {
+            state = State::draining;
+            drainRemaining = getLatencySamples();
+        }
+
+        // The filters still hold the previous output, so keep them in the path
+        // until the delay line holds the samples that come next
+        writeHistory(channels, numChannelsToUse, startSample, numSamples);
+
+        auto block = makeBlock(channels, numChannelsToUse, startSample, numSamples);
+        auto& stage = *stages[(size_t) choice];
+        stage.processSamplesUp(block);
+        stage.processSamplesDown(block);
+
+        drainRemaining -= numSamples;
+
+        if (drainRemaining <= 0)
+            state = State::bypassed;
+    }
+
+private:
+    //==============================================================================
+    enum class State
+    {
+        bypassed,   // host-rate processing plus a plain delay
+        engaged,    // oversampled processing
+        draining    // host-rate processing, still filtered while the delay line fills
+    };
+
+    static juce::dsp::AudioBlock<SampleType> makeBlock(SampleType* const* channels, int numChannelsToUse,
+                                                       int startSample, int numSamples) noexcept
+    {
+        return { channels, (size_t) numChannelsToUse, (size_t) startSample, (size_t) numSamples };
+    }
+
+    void delay(SampleType* const* channels, int numChannelsToUse, int startSample, int numSamples) noexcept
+    {
+        const auto latency = getLatencySamples();
+
+        if (latency == 0)
+            return;
+
+        const auto mask = historySize - 1;
+
+        for (int channel = 0; channel < numChannelsToUse; ++channel)
+        {
+            auto* data = channels[channel] + startSample;
+            auto* line = history.getWritePointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto position = (writePosition + i) & mask;
+                const auto input = data[i];
+                data[i] = line[(position - latency) & mask];
+                line[position] = input;
+            }
+        }
+
+        writePosition = (writePosition + numSamples) & mask;
+    }
+
+    void writeHistory(SampleType* const* channels, int numChannelsToUse, int startSample, int numSamples) noexcept
+    {
+        const auto mask = historySize - 1;
+
+        for (int channel = 0; channel < numChannelsToUse; ++channel)
+        {
+            const auto* data = channels[channel] + startSample;
+            auto* line = history.getWritePointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                line[(writePosition + i) & mask] = data[i];
+        }
+
+        writePosition = (writePosition + numSamples) & mask;
+    }
+
+    // Runs the recent output through freshly reset filters, so their next output
+    // continues where the delay line left off
+    void prime() noexcept
+    {
+        auto& stage = *stages[(size_t) choice];
+        stage.reset();
+
+        const auto mask = historySize - 1;
+        const auto numPrimingSamples = juce::jmin(2 * getLatencySamples(), historySize);
+
+        for (int done = 0; done < numPrimingSamples;)
+        {
+            const auto chunk = juce::jmin(maxSamplesPerBlock, numPrimingSamples - done);
+            const auto readStart = writePosition - numPrimingSamples + done;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* destination = primingBuffer.getWritePointer(channel);
+                const auto* line = history.getReadPointer(channel);
+
+                for (int i = 0; i < chunk; ++i)
+                    destination[i] = line[(readStart + i) & mask];
+            }
+
+            auto block = juce::dsp::AudioBlock<SampleType>(primingBuffer).getSubBlock(0, (size_t) chunk);
+            stage.processSamplesUp(block);
+            stage.processSamplesDown(block);
+            done += chunk;
+        }
+    }
+
+    //==============================================================================
+    std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, numChoices> stages;
+    std::array<int, numChoices> latencies {};
+
+    int choice = 0;
+    int numChannels = 0;
+    int maxSamplesPerBlock = 0;
+    State state = State::bypassed;
+    int drainRemaining = 0;
+
+    // Recent host-rate output, used both as the compensation delay and to prime the filters
+    juce::AudioBuffer<SampleType> history;
+    int historySize = 1;
+    int writePosition = 0;
+
+    juce::AudioBuffer<SampleType> primingBuffer;
+
+    JUCE_LEAK_DETECTOR(ModulationOversampler)
+};
@@ -0,0 +1,293 @@
+#include "MultiStreamEngine.h"
+
+//==============================================================================
+namespace
+{
+    // The same ramp the plugin uses for gain and depth
+    constexpr double rampSeconds = 0.02;
+
+    // The kernels' fixed-point phase has 2^32 steps per cycle
+    constexpr double phaseSteps = 4294967296.0;
+
+    juce::uint32 toFixedPointPhase(float phase) noexcept
+    {
+        // Through int64, so a phase that rounded up to a whole cycle wraps to 0
+        return (juce::uint32) (juce::int64) ((double) phase * phaseSteps);
+    }
+}
+
+//==============================================================================
+// Waits for a range of streams, processes it and reports back, once per block
+class MultiStreamEngine::Worker : public juce::Thread
+{
+public:
+    Worker(MultiStreamEngine& engineToUse, int index)
+        : juce::Thread("Stream worker " + juce::String(index)),
+          engine(engineToUse)
+    {
+        startThread(juce::Thread::Priority::highest);
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        start.signal();
+        stopThread(2000);
+    }
+
+    void run() override
+    {
+        for (;;)
+        {
+            start.wait(-1);
+
+            if (threadShouldExit())
+                return;
+
+            engine.processRange(firstStream, numStreams);
+            engine.workerFinished();
+        }
+    }
+
+    juce::WaitableEvent start;
+    int firstStream = 0;
+    int numStreams = 0;
+
+private:
+    MultiStreamEngine& engine;
+
+    JUCE_DECLARE_NON_COPYABLE(Worker)
+};
+
+//==============================================================================
+MultiStreamEngine::MultiStreamEngine(int numStreamsToUse, int numThreads)
+    : numStreams(juce::jmax(0, numStreamsToUse)),
+      parameters(std::make_unique<StreamParameters[]>((size_t) numStreams)),
+      phases((size_t) numStreams), increments((size_t) numStreams),
+      gains((size_t) numStreams, 1.0f), gainSteps((size_t) numStreams), gainTargets((size_t) numStreams, 1.0f),
+      depths((size_t) numStreams), depthSteps((size_t) numStreams), depthTargets((size_t) numStreams),
+      rampRemaining((size_t) numStreams)
+{
+    state.phase = phases.data();
+    state.increment = increments.data();
+    state.gain = gains.data();
+    state.gainStep = gainSteps.data();
+    state.gainTarget = gainTargets.data();
+    state.depth = depths.data();
+    state.depthStep = depthSteps.data();
+    state.depthTarget = depthTargets.data();
+    state.rampRemaining = rampRemaining.data();
+
+    // No more threads than the stream count can keep busy
+    const auto maxThreads = juce::jmax(1, numStreams / minStreamsPerThread);
+    const auto threadCount = juce::jlimit(1, maxThreads, numThreads > 0 ? numThreads : juce::SystemStats::getNumCpus());
+
+    for (int i = 1; i < threadCount; ++i)
+        workers.push_back(std::make_unique<Worker>(*this, i));
+
+    prepare(sampleRate);
+}
+
+MultiStreamEngine::~MultiStreamEngine()
+{
+    workers.clear();
+}
+
+//==============================================================================
+void MultiStreamEngine::prepare(double newSampleRate)
+{
+    jassert(newSampleRate > 0.0);
+    sampleRate = newSampleRate;
+    rampLength = juce::jmax(1, juce::roundToInt(rampSeconds * sampleRate));
+    performanceMonitor.prepare(sampleRate);
+    reset();
+}
+
+void MultiStreamEngine::reset() noexcept
+{
+    parametersChanged = false;
+
+    for (int stream = 0; stream < numStreams; ++stream)
+    {
+        auto& streamParameters = parameters[(size_t) stream];
+        streamParameters.phaseChanged = false;
+
+        phases[(size_t) stream] = toFixedPointPhase(streamParameters.phase.load());
+        increments[(size_t) stream] = getIncrement(streamParameters.frequency.load());
+        gains[(size_t) stream] = gainTargets[(size_t) stream] = streamParameters.gain.load();
+        depths[(size_t) stream] = depthTargets[(size_t) stream] = streamParameters.depth.load();
+        gainSteps[(size_t) stream] = depthSteps[(size_t) stream] = 0.0f;
+        rampRemaining[(size_t) stream] = 0;
+    }
+}
+
+//==============================================================================
+void MultiStreamEngine::setGain(int stream, float gainDecibels) noexcept
+{
+    jassert(juce::isPositiveAndBelow(stream, numStreams));
+    parameters[(size_t) stream].gain.store(juce::Decibels::decibelsToGain(gainDecibels), std::memory_order_relaxed);
+    parametersChanged.store(true, std::memory_order_release);
+}
+
+void MultiStreamEngine::setModDepth(int stream, float depth) noexcept
+{
+    jassert(juce::isPositiveAndBelow(stream, numStreams));
+    parameters[(size_t) stream].depth.store(juce::jlimit(0.0f, 1.0f, depth), std::memory_order_relaxed);
+    parametersChanged.store(true, std::memory_order_release);
+}
+
+void MultiStreamEngine::setModFrequency(int stream, float frequency) noexcept
+{
+    jassert(juce::isPositiveAndBelow(stream, numStreams));
+    parameters[(size_t) stream].frequency.store(juce::jmax(0.0f, frequency), std::memory_order_relaxed);
+    parametersChanged.store(true, std::memory_order_release);
+}
+
+void MultiStreamEngine::setModPhase(int stream, float phase) noexcept
+{
+    jassert(juce::isPositiveAndBelow(stream, numStreams));
+    auto& streamParameters = parameters[(size_t) stream];
+    streamParameters.phase.store(phase - std::floor(phase), std::memory_order_relaxed);
+    streamParameters.phaseChanged.store(true, std::memory_order_relaxed);
+    parametersChanged.store(true, std::memory_order_release);
+}
+
+void MultiStreamEngine::setShape(ModulationLfo::Shape newShape) noexcept
+{
+    // Sample and hold needs a random step per stream and cycle, which doesn't vectorise
+    jassert(newShape != ModulationLfo::Shape::sampleAndHold);
+
+    switch (newShape)
+    {
+        case ModulationLfo::Shape::triangle:    shape = (int) GainKernels::StreamState::Shape::triangle; break;
+        case ModulationLfo::Shape::saw:         shape = (int) GainKernels::StreamState::Shape::saw; break;
+        case ModulationLfo::Shape::square:      shape = (int) GainKernels::StreamState::Shape::square; break;
+        case ModulationLfo::Shape::sine:
+        case ModulationLfo::Shape::sampleAndHold:
+        default:                                shape = (int) GainKernels::StreamState::Shape::sine; break;
+    }
+}
+
+juce::uint32 MultiStreamEngine::getIncrement(float frequency) const noexcept
+{
+    // Capped at Nyquist, like ModulationLfo, so the phase wraps at most once per sample
+    return (juce::uint32) (juce::jmin(0.5, frequency / sampleRate) * phaseSteps);
+}
+
+//==============================================================================
+void MultiStreamEngine::updateParameters() noexcept
+{
+    state.shape = (GainKernels::StreamState::Shape) shape.load(std::memory_order_relaxed);
+
+    if (! parametersChanged.exchange(false, std::memory_order_acquire))
+        return;
+
+    const auto inverseRampLength = 1.0f / (float) rampLength;
+
+    for (int stream = 0; stream < numStreams; ++stream)
+    {
+        auto& streamParameters = parameters[(size_t) stream];
+        const auto index = (size_t) stream;
+        const auto gain = streamParameters.gain.load(std::memory_order_relaxed);
+        const auto depth = streamParameters.depth.load(std::memory_order_relaxed);
+
+        // A new target ramps both values from where they are now
+        if (gain != gainTargets[index] || depth != depthTargets[index])
+        {
+            gainTargets[index] = gain;
+            depthTargets[index] = depth;
+            gainSteps[index] = (gain - gains[index]) * inverseRampLength;
+            depthSteps[index] = (depth - depths[index]) * inverseRampLength;
+            rampRemaining[index] = rampLength;
+        }
+
+        increments[index] = getIncrement(streamParameters.frequency.load(std::memory_order_relaxed));
+
+        if (streamParameters.phaseChanged.exchange(false, std::memory_order_relaxed))
+            phases[index] = toFixedPointPhase(streamParameters.phase.load(std::memory_order_relaxed));
+    }
+}
+
+void MultiStreamEngine::processRange(int firstStream, int numStreamsInRange) noexcept
+{
+    if (job.floatStreams != nullptr)
+        kernels.floatKernels.processStreams(job.floatStreams, state, firstStream, numStreamsInRange, 0, job.numSamples);
+    else
+        kernels.doubleKernels.processStreams(job.doubleStreams, state, firstStream, numStreamsInRange, 0, job.numSamples);
+}
+
+void MultiStreamEngine::workerFinished() noexcept
+{
+    if (numPendingWorkers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        workersFinished.signal();
+}
+
+template <typename SampleType>
+void MultiStreamEngine::processStreams(SampleType* const* streams, int numStreamsToProcess, int numSamples) noexcept
+{
+    const PerformanceMonitor::ScopedBlockTimer blockTimer(performanceMonitor, numSamples);
+    updateParameters();
+
+    if (numSamples <= 0 || numStreamsToProcess <= 0)
+        return;
+
+    job = {};
+    job.numSamples = numSamples;
+
+    if constexpr (std::is_same_v<SampleType, float>)
+        job.floatStreams = streams;
+    else
+        job.doubleStreams = streams;
+
+    // Whole groups per thread, spread as evenly as the group count allows
+    const auto numGroups = (numStreamsToProcess + GainKernels::streamGroupSize - 1) / GainKernels::streamGroupSize;
+    const auto numThreads = juce::jmin(getNumThreads(), numGroups);
+    const auto numWorkers = numThreads - 1;
+
+    auto rangeStart = [&](int thread)
+    {
+        return juce::jmin(numStreamsToProcess, (numGroups * thread / numThreads) * GainKernels::streamGroupSize);
+    };
+
+    if (numWorkers > 0)
+    {
+        numPendingWorkers = numWorkers;
+
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            auto& worker = *workers[(size_t) i];
+            worker.firstStream = rangeStart(i + 1);
+            worker.numStreams = rangeStart(i + 2) - worker.firstStream;
+            worker.start.signal();
+        }
+    }
+
+    processRange(0, rangeStart(1));
+
+    // Exactly one signal per block, from the last worker to finish
+    if (numWorkers > 0)
+        workersFinished.wait(-1);
+}
+
+void MultiStreamEngine::process(float* const* streams, int numSamples) noexcept
+{
+    processStreams(streams, numStreams, numSamples);
+}
+
+void MultiStreamEngine::process(double* const* streams, int numSamples) noexcept
+{
+    processStreams(streams, numStreams, numSamples);
+}
+
+void MultiStreamEngine::process(juce::AudioBuffer<float>& buffer) noexcept
+{
+    // A narrower buffer only gets its own channels processed; the streams past it stand still
+    jassert(buffer.getNumChannels() == numStreams);
+    processStreams(buffer.getArrayOfWritePointers(), juce::jmin(buffer.getNumChannels(), numStreams), buffer.getNumSamples());
+}
+
+void MultiStreamEngine::process(juce::AudioBuffer<double>& buffer) noexcept
+{
+    jassert(buffer.getNumChannels() == numStreams);
+    processStreams(buffer.getArrayOfWritePointers(), juce::jmin(buffer.getNumChannels(), numStreams), buffer.getNumSamples());
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "KernelDispatch.h"
+#include "ModulationLfo.h"
+#include "PerformanceMonitor.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+
+//==============================================================================
+/**
+ * MultiStreamEngine applies the plugin's gain and LFO modulation to many
+ * independent mono streams at once, each with its own gain, depth, rate and
+ * LFO phase, without a SimpleGainProcessor per stream.
+ *
+ * The per-stream state lives in structure-of-arrays form, and
+ * GainKernels::processStreams works across the streams: one vector operation
+ * evaluates several streams' LFOs at a control point, and each stream's audio
+ * is then scaled by the interpolated envelope in one contiguous pass. Large
+ * stream sets are split into contiguous ranges that worker threads process
+ * alongside the calling thread; process() returns once every range is done.
+ *
+ * Parameters can be set from any thread and take effect at the start of the
+ * next block, ramping over 20 ms like the plugin's gain and depth. Frequency
+ * changes apply at once, since the LFO phase stays continuous anyway. All
+ * streams share one LFO shape; sample and hold isn't available.
+ */
+class MultiStreamEngine
+{
+public:
+    // numThreads includes the thread that calls process(); 0 uses one per CPU core
+    explicit MultiStreamEngine(int numStreams, int numThreads = 0);
+    ~MultiStreamEngine();
+
+    //==============================================================================
+    // Not while processing. Finishes every ramp and puts each LFO at its start phase.
+    void prepare(double sampleRate);
+    void reset() noexcept;
+
+    int getNumStreams() const noexcept     { return numStreams; }
+    int getNumThreads() const noexcept     { return (int) workers.size() + 1; }
+
+    //==============================================================================
+    // Any thread
+    void setGain(int stream, float gainDecibels) noexcept;
+    void setModDepth(int stream, float depth) noexcept;
+    void setModFrequency(int stream, float frequency) noexcept;
+
+    // Moves the stream's LFO to this phase (in cycles) at the next block, and on reset()
+    void setModPhase(int stream, float phase) noexcept;
+
+    void setShape(ModulationLfo::Shape newShape) noexcept;
+
+    //==============================================================================
+    // Processes streams[0..getNumStreams()) in place, numSamples samples each
+    void process(float* const* streams, int numSamples) noexcept;
+    void process(double* const* streams, int numSamples) noexcept;
+
+    // One channel per stream; with fewer channels than streams, only that many streams are processed
+    void process(juce::AudioBuffer<float>& buffer) noexcept;
+    void process(juce::AudioBuffer<double>& buffer) noexcept;
+
+    PerformanceMonitor& getPerformanceMonitor() noexcept   { return performanceMonitor; }
+
+    // Below this many streams per thread, waking another thread costs more than it saves
+    static constexpr int minStreamsPerThread = 4 * GainKernels::streamGroupSize;
+
+private:
+    //==============================================================================
+    class Worker;
+
+    // Written by the setters, read at the start of each block
+    struct StreamParameters
+    {
+        std::atomic<float> gain { 1.0f };   // linear
+        std::atomic<float> depth { 0.0f };
+        std::atomic<float> frequency { 1.0f };
+        std::atomic<float> phase { 0.0f };
+        std::atomic<bool> phaseChanged { false };
+    };
+
+    // The block being processed, shared with the workers
+    struct Job
+    {
+        float* const* floatStreams = nullptr;
+        double* const* doubleStreams = nullptr;
+        int numSamples = 0;
+    };
+
+    //==============================================================================
+    void updateParameters() noexcept;
+    juce::uint32 getIncrement(float frequency) const noexcept;
+
+    template <typename SampleType>
+    void processStreams(SampleType* const* streams, int numStreamsToProcess, int numSamples) noexcept;
+
+    void processRange(int firstStream, int numStreamsInRange) noexcept;
+    void workerFinished() noexcept;
+
+    //==============================================================================
+    const int numStreams;
+    const KernelDispatch::KernelTable& kernels { KernelDispatch::getKernels() };
+
+    std::unique_ptr<StreamParameters[]> parameters;
+    std::atomic<bool> parametersChanged { false };
+    std::atomic<int> shape { (int) GainKernels::StreamState::Shape::sine };
+
+    // Audio thread state, one entry per stream
+    std::vector<juce::uint32> phases, increments;
+    std::vector<float> gains, gainSteps, gainTargets;
+    std::vector<float> depths, depthSteps, depthTargets;
+    std::vector<int> rampRemaining;
+    GainKernels::StreamState state;
+
+    double sampleRate = 44100.0;
+    int rampLength = 882;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    Job job;
+    std::atomic<int> numPendingWorkers { 0 };
+    juce::WaitableEvent workersFinished;
+
+    PerformanceMonitor performanceMonitor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MultiStreamEngine)
+};
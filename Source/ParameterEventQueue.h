@@ -0,0 +1,118 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+
+//==============================================================================
+/** A single parameter change on its way to the audio thread. */
+struct ParameterEvent
+{
+    int parameterIndex = 0;
+    float value = 0.0f;
+};
+
+//==============================================================================
+/**
+ * ParameterEventQueue carries parameter changes from the UI and automation
+ * threads to the audio thread through a fixed-size ring buffer.
+ *
+ * Hosts report changes from more than one thread, including the audio thread
+ * itself, so this is a bounded multi-producer queue: each slot carries a
+ * sequence number, and producers claim slots with a compare-and-swap on the
+ * write position. No side ever blocks, spins behind another thread or
+ * allocates. If the queue fills up, the overflow flag tells the audio thread
+ * to resynchronise from the latest values instead.
+ */
+class ParameterEventQueue
+{
+public:
+    static constexpr int capacity = 256;
+    static_assert((capacity & (capacity - 1)) == 0, "Capacity must be a power of two");
+
+    ParameterEventQueue() noexcept
+    {
+        for (size_t i = 0; i < slots.size(); ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    // Producer side, callable from any thread
+    bool push(int parameterIndex, float value) noexcept
+    {
+        auto position = writePosition.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& slot = slots[position & slotMask];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto difference = (std::ptrdiff_t) (sequence - position);
+
+            if (difference == 0)
+            {
+                // The slot is free: claim it, or retry from wherever another producer left the position
+                if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.event.parameterIndex = parameterIndex;
+                    slot.event.value = value;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                // The consumer hasn't freed this slot yet, so the queue is full
+                overflowed = true;
+                return false;
+            }
+            else
+            {
+                position = writePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //==============================================================================
+    // Consumer side: copies up to maxEvents pending events and returns how many were copied.
+    // A slot claimed by a producer that hasn't finished writing it ends the run; it is
+    // picked up on the next call.
+    int pop(ParameterEvent* destination, int maxEvents) noexcept
+    {
+        int numPopped = 0;
+
+        while (numPopped < maxEvents)
+        {
+            auto& slot = slots[readPosition & slotMask];
+
+            if (slot.sequence.load(std::memory_order_acquire) != readPosition + 1)
+                break;
+
+            destination[numPopped++] = slot.event;
+            slot.sequence.store(readPosition + (size_t) capacity, std::memory_order_release);
+            ++readPosition;
+        }
+
+        return numPopped;
+    }
+
+    bool checkAndClearOverflow() noexcept
+    {
+        return overflowed.exchange(false);
+    }
+
+private:
+    //==============================================================================
+    struct Slot
+    {
+        std::atomic<size_t> sequence { 0 };
+        ParameterEvent event;
+    };
+
+    static constexpr size_t slotMask = (size_t) capacity - 1;
+
+    std::array<Slot, capacity> slots;
+    std::atomic<size_t> writePosition { 0 };
+    size_t readPosition = 0;    // audio thread only
+    std::atomic<bool> overflowed { false };
+
+    JUCE_DECLARE_NON_COPYABLE(ParameterEventQueue)
+};
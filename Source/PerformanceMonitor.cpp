@@ -0,0 +1,211 @@
+#include "PerformanceMonitor.h"
+#include <cstdlib>
+#include <new>
+
+#if SIMPLEGAIN_DETECT_RT_VIOLATIONS && JUCE_DEBUG && JUCE_LINUX && defined(__GLIBC__)
+ #include <pthread.h>
+ #define SIMPLEGAIN_DETECT_RT_LOCKS 1
+#else
+ #define SIMPLEGAIN_DETECT_RT_LOCKS 0
+#endif
+
+//==============================================================================
+// Real-time violation detection (debug builds only)
+namespace
+{
+    // The monitor whose ScopedBlockTimer is innermost on this thread
+    thread_local PerformanceMonitor* activeMonitor = nullptr;
+}
+
+#if SIMPLEGAIN_DETECT_RT_VIOLATIONS && JUCE_DEBUG
+// The plugin is built with hidden symbol visibility, so these replacements only
+// affect code linked into this binary, not the host.
+void* operator new(std::size_t size)
+{
+    PerformanceMonitor::countAllocationViolation();
+
+    if (auto* memory = std::malloc(size != 0 ? size : 1))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept                 { std::free(memory); }
+void operator delete[](void* memory) noexcept               { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept    { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept  { std::free(memory); }
+#endif
+
+#if SIMPLEGAIN_DETECT_RT_LOCKS
+extern "C" int __pthread_mutex_lock(pthread_mutex_t*);
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    PerformanceMonitor::countLockViolation();
+
+    return __pthread_mutex_lock(mutex);
+}
+#endif
+
+//==============================================================================
+void PerformanceMonitor::Statistics::add(const BlockRecord& record) noexcept
+{
+    ++numBlocks;
+    totalNanoseconds += record.nanoseconds;
+    totalBudgetNanoseconds += record.budgetNanoseconds;
+    totalCycles += (double) record.cycles;
+    totalSamples += (juce::uint64) record.numSamples;
+    maxNanoseconds = juce::jmax(maxNanoseconds, record.nanoseconds);
+
+    if (record.budgetNanoseconds > 0.0f)
+        maxBudgetPercent = juce::jmax(maxBudgetPercent, 100.0f * record.nanoseconds / record.budgetNanoseconds);
+
+    auto bucket = 0;
+
+    for (auto ns = (juce::uint64) record.nanoseconds; ns > 1 && bucket < numHistogramBuckets - 1; ns >>= 1)
+        ++bucket;
+
+    ++histogram[(size_t) bucket];
+}
+
+double PerformanceMonitor::Statistics::getAverageBudgetPercent() const noexcept
+{
+    return totalBudgetNanoseconds > 0.0 ? 100.0 * totalNanoseconds / totalBudgetNanoseconds : 0.0;
+}
+
+double PerformanceMonitor::Statistics::getAverageNanosecondsPerSample() const noexcept
+{
+    return totalSamples > 0 ? totalNanoseconds / (double) totalSamples : 0.0;
+}
+
+double PerformanceMonitor::Statistics::getAverageCyclesPerSample() const noexcept
+{
+    return hasCycleCounter && totalSamples > 0 ? totalCycles / (double) totalSamples : -1.0;
+}
+
+juce::String PerformanceMonitor::Statistics::toJson() const
+{
+    auto* object = new juce::DynamicObject();
+    object->setProperty("blocks", (juce::int64) numBlocks);
+    object->setProperty("overruns", (juce::int64) numOverruns);
+    object->setProperty("dropped_records", (juce::int64) numDropped);
+    object->setProperty("average_budget_percent", getAverageBudgetPercent());
+    object->setProperty("max_budget_percent", maxBudgetPercent);
+    object->setProperty("max_block_ns", maxNanoseconds);
+    object->setProperty("ns_per_sample", getAverageNanosecondsPerSample());
+    object->setProperty("cycles_per_sample", getAverageCyclesPerSample());
+    object->setProperty("allocation_violations", (int) allocationViolations);
+    object->setProperty("lock_violations", (int) lockViolations);
+
+    juce::Array<juce::var> buckets;
+
+    for (auto count : histogram)
+        buckets.add((juce::int64) count);
+
+    object->setProperty("histogram_log2_ns", buckets);
+    return juce::JSON::toString(juce::var(object));
+}
+
+//==============================================================================
+PerformanceMonitor::ScopedBlockTimer::ScopedBlockTimer(PerformanceMonitor& monitorToUse, int numSamplesInBlock) noexcept
+    : monitor(monitorToUse),
+      enclosingMonitor(activeMonitor),
+      numSamples(numSamplesInBlock),
+      startTicks(juce::Time::getHighResolutionTicks()),
+      startCycles(readCycleCounter())
+{
+    activeMonitor = &monitor;
+}
+
+PerformanceMonitor::ScopedBlockTimer::~ScopedBlockTimer() noexcept
+{
+    // A timer nested in another one, e.g. the processor's inside the headless engine's,
+    // hands the thread back to the outer one
+    activeMonitor = enclosingMonitor;
+
+    const auto endCycles = readCycleCounter();
+    const auto elapsedSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    BlockRecord record;
+    record.cycles = endCycles - startCycles;
+    record.nanoseconds = (float) (elapsedSeconds * 1.0e9);
+    record.budgetNanoseconds = (float) (1.0e9 * numSamples / monitor.currentSampleRate);
+    record.numSamples = numSamples;
+
+    monitor.push(record);
+}
+
+//==============================================================================
+void PerformanceMonitor::prepare(double sampleRate) noexcept
+{
+    currentSampleRate = sampleRate > 0.0 ? sampleRate : 44100.0;
+}
+
+void PerformanceMonitor::countAllocationViolation() noexcept
+{
+    if (auto* monitor = activeMonitor)
+        monitor->allocationViolations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerformanceMonitor::countLockViolation() noexcept
+{
+    if (auto* monitor = activeMonitor)
+        monitor->lockViolations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerformanceMonitor::push(const BlockRecord& record) noexcept
+{
+    if (record.nanoseconds > record.budgetNanoseconds)
+        overruns.fetch_add(1, std::memory_order_relaxed);
+
+    auto scope = fifo.write(1);
+
+    if (scope.blockSize1 + scope.blockSize2 == 0)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = record;
+}
+
+void PerformanceMonitor::update()
+{
+    const juce::ScopedLock lock(statisticsLock);
+
+    fifo.read(fifo.getNumReady()).forEach([this](int index) { statistics.add(ring[(size_t) index]); });
+
+    statistics.numOverruns = overruns.load(std::memory_order_relaxed);
+    statistics.numDropped = dropped.load(std::memory_order_relaxed);
+    statistics.allocationViolations = allocationViolations.load(std::memory_order_relaxed);
+    statistics.lockViolations = lockViolations.load(std::memory_order_relaxed);
+}
+
+PerformanceMonitor::Statistics PerformanceMonitor::getStatistics()
+{
+    const juce::ScopedLock lock(statisticsLock);
+    return statistics;
+}
+
+void PerformanceMonitor::resetStatistics()
+{
+    const juce::ScopedLock lock(statisticsLock);
+
+    fifo.read(fifo.getNumReady());
+    overruns = 0;
+    dropped = 0;
+    allocationViolations = 0;
+    lockViolations = 0;
+    statistics = {};
+}
+
+bool PerformanceMonitor::writeReport(const juce::File& file)
+{
+    update();
+    return file.replaceWithText(getStatistics().toJson() + "\n");
+}
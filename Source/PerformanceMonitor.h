@@ -0,0 +1,149 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+#ifndef SIMPLEGAIN_INSTRUMENTATION
+ #define SIMPLEGAIN_INSTRUMENTATION 1
+#endif
+
+#ifndef SIMPLEGAIN_DETECT_RT_VIOLATIONS
+ #define SIMPLEGAIN_DETECT_RT_VIOLATIONS 0
+#endif
+
+//==============================================================================
+/**
+ * PerformanceMonitor measures how much of the real-time deadline each
+ * processBlock call uses.
+ *
+ * The audio thread only reads the clocks, bumps a few atomics and pushes one
+ * record into a lock-free ring buffer. Histograms and summaries are built on
+ * whichever thread calls update(), e.g. the editor's timer or a headless run
+ * that writes a report file.
+ *
+ * With SIMPLEGAIN_DETECT_RT_VIOLATIONS in a debug build, memory allocations
+ * and mutex locks made while a block is being timed are counted as well, by
+ * the monitor whose timer is innermost on that thread.
+ */
+class PerformanceMonitor
+{
+public:
+    //==============================================================================
+    struct BlockRecord
+    {
+        juce::uint64 cycles = 0;
+        float nanoseconds = 0.0f;
+        float budgetNanoseconds = 0.0f;
+        int numSamples = 0;
+    };
+
+    //==============================================================================
+    struct Statistics
+    {
+        // Bucket i counts blocks that took [2^i, 2^(i+1)) ns
+        static constexpr int numHistogramBuckets = 32;
+
+        juce::uint64 numBlocks = 0;
+        juce::uint64 numOverruns = 0;
+        juce::uint64 numDropped = 0;
+        double totalNanoseconds = 0.0;
+        double totalBudgetNanoseconds = 0.0;
+        double totalCycles = 0.0;
+        juce::uint64 totalSamples = 0;
+        float maxNanoseconds = 0.0f;
+        float maxBudgetPercent = 0.0f;
+        std::array<juce::uint64, numHistogramBuckets> histogram {};
+
+        juce::uint32 allocationViolations = 0;
+        juce::uint32 lockViolations = 0;
+
+        void add(const BlockRecord& record) noexcept;
+
+        double getAverageBudgetPercent() const noexcept;
+        double getAverageNanosecondsPerSample() const noexcept;
+        double getAverageCyclesPerSample() const noexcept;
+
+        juce::String toJson() const;
+    };
+
+    //==============================================================================
+    /** Times one processBlock call; create it on the audio thread at the top of the block. */
+    class ScopedBlockTimer
+    {
+    public:
+        ScopedBlockTimer(PerformanceMonitor& monitorToUse, int numSamples) noexcept;
+        ~ScopedBlockTimer() noexcept;
+
+    private:
+        PerformanceMonitor& monitor;
+        PerformanceMonitor* enclosingMonitor;   // timing this thread when the block started, if any
+        int numSamples;
+        juce::int64 startTicks;
+        juce::uint64 startCycles;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlockTimer)
+    };
+
+    //==============================================================================
+    void prepare(double sampleRate) noexcept;
+
+    // Drains pending records into the statistics; call from a non-audio thread
+    void update();
+    Statistics getStatistics();
+    void resetStatistics();
+
+    bool writeReport(const juce::File& file);
+
+    // Audio-thread counters, available even if nobody drains the ring buffer
+    juce::uint64 getNumOverruns() const noexcept { return overruns.load(std::memory_order_relaxed); }
+
+    // Called by the violation hooks; counted against the monitor timing the calling thread, if any
+    static void countAllocationViolation() noexcept;
+    static void countLockViolation() noexcept;
+
+    //==============================================================================
+    // Time stamp counter, or 0 where none is available
+    static inline juce::uint64 readCycleCounter() noexcept
+    {
+       #if JUCE_INTEL
+        return (juce::uint64) __rdtsc();
+       #else
+        return 0;
+       #endif
+    }
+
+   #if JUCE_INTEL
+    static constexpr bool hasCycleCounter = true;
+   #else
+    static constexpr bool hasCycleCounter = false;
+   #endif
+
+private:
+    //==============================================================================
+    void push(const BlockRecord& record) noexcept;
+
+    static constexpr int ringSize = 4096;
+
+    double currentSampleRate = 44100.0;
+    std::atomic<juce::uint64> overruns { 0 };
+    std::atomic<juce::uint64> dropped { 0 };
+    std::atomic<juce::uint32> allocationViolations { 0 };
+    std::atomic<juce::uint32> lockViolations { 0 };
+
+    juce::AbstractFifo fifo { ringSize };
+    std::array<BlockRecord, ringSize> ring;
+
+    // Consumer side
+    juce::CriticalSection statisticsLock;
+    Statistics statistics;
+
+    JUCE_LEAK_DETECTOR(PerformanceMonitor)
+};
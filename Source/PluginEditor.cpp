@@ -4,20 +4,73 @@
 #include "BinaryData.h"
 
 //==============================================================================
-SimpleGainEditor::SimpleGainEditor(SimpleGainProcessor& p)
-    : AudioProcessorEditor(&p), processor(p)
+namespace
+{
+    // Parameters shown in the value display
+    const juce::String* const displayedParameterIDs[] = { &SimpleGainProcessor::gainID,
+                                                          &SimpleGainProcessor::modFreqID,
+                                                          &SimpleGainProcessor::modDepthID };
+
+    // The DSP load display is refreshed every few timer ticks
+    constexpr int performanceUpdateInterval = 10;
+}
+
+//==============================================================================
+struct SimpleGainEditor::SharedAssets
 {
-    // Load the background image
-    int size = 0;
-    const char* imageData = BinaryData::getNamedResource("Untitled_jpg", size);
-    if (imageData != nullptr && size > 0)
+    SharedAssets()
     {
-        backgroundImage = juce::ImageCache::getFromMemory(imageData, size);
+        // Decode the background once, rather than once per editor
+        int size = 0;
+        
+        if (auto* imageData = BinaryData::getNamedResource("Untitled_jpg", size))
+            backgroundImage = juce::ImageFileFormat::loadFrom(imageData, (size_t) size);
     }
+    
+    // Editors of the same size and scale share one rendering of the background and chrome
+    juce::Image getRenderedBackground(int width, int height, float scale,
+                                      const std::function<void(juce::Graphics&)>& render)
+    {
+        if (! renderedBackground.isValid() || width != renderedWidth || height != renderedHeight || scale != renderedScale)
+        {
+            renderedBackground = juce::Image(juce::Image::RGB,
+                                             juce::roundToInt(width * scale),
+                                             juce::roundToInt(height * scale),
+                                             false);
+            
+            juce::Graphics g(renderedBackground);
+            g.addTransform(juce::AffineTransform::scale(scale));
+            render(g);
+            
+            renderedWidth = width;
+            renderedHeight = height;
+            renderedScale = scale;
+        }
+        
+        return renderedBackground;
+    }
+    
+    juce::Image backgroundImage;
+    
+    const juce::Font titleFont { 24.0f, juce::Font::bold };
+    const juce::Font labelFont { 16.0f };
+    const juce::Font valueFont { 16.0f, juce::Font::bold };
+    const juce::Font smallFont { 12.0f };
+    
+private:
+    juce::Image renderedBackground;
+    int renderedWidth = 0;
+    int renderedHeight = 0;
+    float renderedScale = 0.0f;
+};
 
+//==============================================================================
+SimpleGainEditor::SimpleGainEditor(SimpleGainProcessor& p)
+    : AudioProcessorEditor(&p), processor(p)
+{
     // Set up title label
     titleLabel.setText("Simple Gain + FM", juce::dontSendNotification);
-    titleLabel.setFont(juce::Font(24.0f, juce::Font::bold));
+    titleLabel.setFont(assets->titleFont);
     titleLabel.setJustificationType(juce::Justification::centred);
     titleLabel.setColour(juce::Label::textColourId, textColour);
     addAndMakeVisible(titleLabel);
@@ -49,33 +102,138 @@ SimpleGainEditor::SimpleGainEditor(SimpleGainProcessor& p)
     modDepthSlider.addListener(this);
     addAndMakeVisible(modDepthSlider);
     
+    // Set up modulation shape selector (items must exist before the attachment is created)
+    modShapeBox.addItemList(processor.getParameters().getParameter(SimpleGainProcessor::modShapeID)->getAllValueStrings(), 1);
+    modShapeBox.setColour(juce::ComboBox::backgroundColourId, backgroundColour.withAlpha(0.8f));
+    modShapeBox.setColour(juce::ComboBox::outlineColourId, accentColour.withAlpha(0.4f));
+    modShapeBox.setColour(juce::ComboBox::textColourId, textColour);
+    addAndMakeVisible(modShapeBox);
+    
+    // Set up oversampling selector, sharing the shape selector's row
+    int oversamplingItemId = 1;
+    
+    for (auto& name : processor.getParameters().getParameter(SimpleGainProcessor::oversamplingID)->getAllValueStrings())
+        oversamplingBox.addItem("OS " + name, oversamplingItemId++);
+    
+    oversamplingBox.setColour(juce::ComboBox::backgroundColourId, backgroundColour.withAlpha(0.8f));
+    oversamplingBox.setColour(juce::ComboBox::outlineColourId, accentColour.withAlpha(0.4f));
+    oversamplingBox.setColour(juce::ComboBox::textColourId, textColour);
+    addAndMakeVisible(oversamplingBox);
+    
+    // Set up the output stage row: clip mode, ceiling and true-peak metering
+    clipModeBox.addItemList(processor.getParameters().getParameter(SimpleGainProcessor::clipModeID)->getAllValueStrings(), 1);
+    clipModeBox.setColour(juce::ComboBox::backgroundColourId, backgroundColour.withAlpha(0.8f));
+    clipModeBox.setColour(juce::ComboBox::outlineColourId, accentColour.withAlpha(0.4f));
+    clipModeBox.setColour(juce::ComboBox::textColourId, textColour);
+    addAndMakeVisible(clipModeBox);
+    
+    ceilingSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    ceilingSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 56, 20);
+    ceilingSlider.setTextValueSuffix(" dB");
+    ceilingSlider.setColour(juce::Slider::trackColourId, accentColour);
+    ceilingSlider.setColour(juce::Slider::thumbColourId, accentColour);
+    ceilingSlider.setColour(juce::Slider::textBoxTextColourId, textColour);
+    ceilingSlider.setColour(juce::Slider::textBoxOutlineColourId, juce::Colours::transparentBlack);
+    addAndMakeVisible(ceilingSlider);
+    
+    truePeakButton.setButtonText("TP");
+    truePeakButton.setColour(juce::ToggleButton::textColourId, textColour);
+    truePeakButton.setColour(juce::ToggleButton::tickColourId, accentColour);
+    addAndMakeVisible(truePeakButton);
+    
+    // Set up the stereo rows: mode and LFO phase offset, then the mid and side gains
+    stereoModeBox.addItemList(processor.getParameters().getParameter(SimpleGainProcessor::stereoModeID)->getAllValueStrings(), 1);
+    stereoModeBox.setColour(juce::ComboBox::backgroundColourId, backgroundColour.withAlpha(0.8f));
+    stereoModeBox.setColour(juce::ComboBox::outlineColourId, accentColour.withAlpha(0.4f));
+    stereoModeBox.setColour(juce::ComboBox::textColourId, textColour);
+    addAndMakeVisible(stereoModeBox);
+    
+    auto setUpLinearSlider = [this](juce::Slider& slider, const juce::String& suffix)
+    {
+        slider.setSliderStyle(juce::Slider::LinearHorizontal);
+        slider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 56, 20);
+        slider.setTextValueSuffix(suffix);
+        slider.setColour(juce::Slider::trackColourId, accentColour);
+        slider.setColour(juce::Slider::thumbColourId, accentColour);
+        slider.setColour(juce::Slider::textBoxTextColourId, textColour);
+        slider.setColour(juce::Slider::textBoxOutlineColourId, juce::Colours::transparentBlack);
+        addAndMakeVisible(slider);
+    };
+    
+    setUpLinearSlider(stereoPhaseSlider, juce::String(juce::CharPointer_UTF8("\xc2\xb0")));
+    setUpLinearSlider(midGainSlider, " dB");
+    setUpLinearSlider(sideGainSlider, " dB");
+    
     // Set up labels
     gainLabel.setText("Gain", juce::dontSendNotification);
-    gainLabel.setFont(juce::Font(16.0f));
+    gainLabel.setFont(assets->labelFont);
     gainLabel.setJustificationType(juce::Justification::centred);
     gainLabel.setColour(juce::Label::textColourId, textColour);
     addAndMakeVisible(gainLabel);
     
     modFreqLabel.setText("Mod Freq", juce::dontSendNotification);
-    modFreqLabel.setFont(juce::Font(16.0f));
+    modFreqLabel.setFont(assets->labelFont);
     modFreqLabel.setJustificationType(juce::Justification::centred);
     modFreqLabel.setColour(juce::Label::textColourId, textColour);
     addAndMakeVisible(modFreqLabel);
     
     modDepthLabel.setText("Mod Depth", juce::dontSendNotification);
-    modDepthLabel.setFont(juce::Font(16.0f));
+    modDepthLabel.setFont(assets->labelFont);
     modDepthLabel.setJustificationType(juce::Justification::centred);
     modDepthLabel.setColour(juce::Label::textColourId, textColour);
     addAndMakeVisible(modDepthLabel);
     
+    modShapeLabel.setText("Mod Shape", juce::dontSendNotification);
+    modShapeLabel.setFont(assets->labelFont);
+    modShapeLabel.setJustificationType(juce::Justification::centredRight);
+    modShapeLabel.setColour(juce::Label::textColourId, textColour);
+    addAndMakeVisible(modShapeLabel);
+    
+    auto setUpSmallLabel = [this](juce::Label& label, const juce::String& name)
+    {
+        label.setText(name, juce::dontSendNotification);
+        label.setFont(assets->smallFont);
+        label.setJustificationType(juce::Justification::centredRight);
+        label.setColour(juce::Label::textColourId, textColour);
+        addAndMakeVisible(label);
+    };
+    
+    setUpSmallLabel(midGainLabel, "Mid");
+    setUpSmallLabel(sideGainLabel, "Side");
+    
     // Set up value display label
-    valueLabel.setFont(juce::Font(16.0f, juce::Font::bold));
+    valueLabel.setFont(assets->valueFont);
     valueLabel.setJustificationType(juce::Justification::centred);
     valueLabel.setColour(juce::Label::textColourId, textColour);
     valueLabel.setColour(juce::Label::backgroundColourId, juce::Colours::transparentBlack);
     valueLabel.setColour(juce::Label::outlineColourId, juce::Colours::transparentBlack);
     addAndMakeVisible(valueLabel);
     
+    // Set up level meters
+    auto setUpMeter = [this](LevelMeter& meter, juce::Label& label, const juce::String& name)
+    {
+        addAndMakeVisible(meter);
+        label.setText(name, juce::dontSendNotification);
+        label.setFont(assets->smallFont);
+        label.setJustificationType(juce::Justification::centredRight);
+        label.setColour(juce::Label::textColourId, textColour);
+        addAndMakeVisible(label);
+    };
+    
+    setUpMeter(inputMeter, inputMeterLabel, "In");
+    setUpMeter(outputMeter, outputMeterLabel, "Out");
+    setUpMeter(modulationMeter, modulationMeterLabel, "Mod");
+    modulationMeter.setBarColour(accentColour.brighter(0.4f));
+    processor.setMeteringEnabled(true);
+    
+    // Set up DSP load display
+    performanceLabel.setFont(assets->smallFont);
+    performanceLabel.setJustificationType(juce::Justification::centred);
+    performanceLabel.setColour(juce::Label::textColourId, textColour.withAlpha(0.7f));
+   #if SIMPLEGAIN_INSTRUMENTATION
+    addAndMakeVisible(performanceLabel);
+   #endif
+    
     // Create parameter attachments
     try
     {
@@ -87,6 +245,33 @@ SimpleGainEditor::SimpleGainEditor(SimpleGainProcessor& p)
             
         modDepthAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(
             processor.getParameters(), SimpleGainProcessor::modDepthID, modDepthSlider));
+            
+        modShapeAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(
+            processor.getParameters(), SimpleGainProcessor::modShapeID, modShapeBox));
+            
+        oversamplingAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(
+            processor.getParameters(), SimpleGainProcessor::oversamplingID, oversamplingBox));
+            
+        clipModeAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(
+            processor.getParameters(), SimpleGainProcessor::clipModeID, clipModeBox));
+            
+        ceilingAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(
+            processor.getParameters(), SimpleGainProcessor::ceilingID, ceilingSlider));
+            
+        truePeakAttachment.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(
+            processor.getParameters(), SimpleGainProcessor::truePeakID, truePeakButton));
+            
+        stereoModeAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(
+            processor.getParameters(), SimpleGainProcessor::stereoModeID, stereoModeBox));
+            
+        stereoPhaseAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(
+            processor.getParameters(), SimpleGainProcessor::stereoPhaseID, stereoPhaseSlider));
+            
+        midGainAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(
+            processor.getParameters(), SimpleGainProcessor::midGainID, midGainSlider));
+            
+        sideGainAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(
+            processor.getParameters(), SimpleGainProcessor::sideGainID, sideGainSlider));
     }
     catch (...)
     {
@@ -94,58 +279,117 @@ SimpleGainEditor::SimpleGainEditor(SimpleGainProcessor& p)
         gainAttachment.reset();
         modFreqAttachment.reset();
         modDepthAttachment.reset();
+        modShapeAttachment.reset();
+        oversamplingAttachment.reset();
+        clipModeAttachment.reset();
+        ceilingAttachment.reset();
+        truePeakAttachment.reset();
+        stereoModeAttachment.reset();
+        stereoPhaseAttachment.reset();
+        midGainAttachment.reset();
+        sideGainAttachment.reset();
     }
     
+    // Labels that never change are cached as images
+    for (auto* label : { &titleLabel, &gainLabel, &modFreqLabel, &modDepthLabel, &modShapeLabel,
+                         &inputMeterLabel, &outputMeterLabel, &modulationMeterLabel, &midGainLabel, &sideGainLabel })
+        label->setBufferedToImage(true);
+    
+    // Only rebuild the value text when one of its parameters changes
+    for (auto* parameterID : displayedParameterIDs)
+        processor.getParameters().addParameterListener(*parameterID, this);
+    
+   #if SIMPLEGAIN_OPENGL_EDITOR
+    openGLContext.attachTo(*this);
+   #endif
+    
     // Start a timer to update the display
     startTimerHz(30);
     
     // Set editor size
-    setSize(400, 500);
+    setSize(400, 560);
 }
 
 SimpleGainEditor::~SimpleGainEditor()
 {
     stopTimer();
+    processor.setMeteringEnabled(false);
+    
+    for (auto* parameterID : displayedParameterIDs)
+        processor.getParameters().removeParameterListener(*parameterID, this);
+    
+   #if SIMPLEGAIN_OPENGL_EDITOR
+    openGLContext.detach();
+   #endif
     gainAttachment.reset();
     modFreqAttachment.reset();
     modDepthAttachment.reset();
+    modShapeAttachment.reset();
+    oversamplingAttachment.reset();
+    clipModeAttachment.reset();
+    ceilingAttachment.reset();
+    truePeakAttachment.reset();
+    stereoModeAttachment.reset();
+    stereoPhaseAttachment.reset();
+    midGainAttachment.reset();
+    sideGainAttachment.reset();
 }
 
 //==============================================================================
 void SimpleGainEditor::paint(juce::Graphics& g)
 {
-    // Draw the background image if available
-    if (backgroundImage.isValid())
-    {
-        g.drawImage(backgroundImage, getLocalBounds().toFloat(), juce::RectanglePlacement::stretchToFit);
-    }
+    // Everything static was rendered in resized(), so this is a single image blit
+    if (cachedBackground.isValid())
+        g.drawImage(cachedBackground, getLocalBounds().toFloat());
     else
-    {
-        // Fallback to solid color if image is not available
-        g.fillAll(juce::Colour(30, 30, 30));
-    }
-    
-    // Draw rounded rectangles around the controls
-    auto drawControlBackground = [&](const juce::Rectangle<float>& bounds)
-    {
-        g.setColour(accentColour.withAlpha(0.1f));
-        g.fillRoundedRectangle(bounds, 10.0f);
-        g.setColour(accentColour.withAlpha(0.2f));
-        g.drawRoundedRectangle(bounds, 10.0f, 1.0f);
-    };
+        g.fillAll(backgroundColour);
+}
+
+void SimpleGainEditor::renderBackground()
+{
+    if (getWidth() <= 0 || getHeight() <= 0)
+        return;
     
-    float controlWidth = getWidth() * 0.25f;
-    float controlHeight = controlWidth;
-    float yPos = getHeight() * 0.25f;
+    // Render at the display's pixel density so the cache stays sharp
+    const auto scale = juce::Component::getApproximateScaleFactorForComponent(this);
     
-    // Draw backgrounds for each control
-    drawControlBackground(juce::Rectangle<float>(getWidth() * 0.1f, yPos, controlWidth, controlHeight));
-    drawControlBackground(juce::Rectangle<float>(getWidth() * 0.4f, yPos, controlWidth, controlHeight));
-    drawControlBackground(juce::Rectangle<float>(getWidth() * 0.7f, yPos, controlWidth, controlHeight));
+    cachedBackground = assets->getRenderedBackground(getWidth(), getHeight(), scale, [this](juce::Graphics& g)
+    {
+        // Draw the background image if available
+        if (assets->backgroundImage.isValid())
+        {
+            g.drawImage(assets->backgroundImage, getLocalBounds().toFloat(), juce::RectanglePlacement::stretchToFit);
+        }
+        else
+        {
+            // Fallback to solid color if image is not available
+            g.fillAll(juce::Colour(30, 30, 30));
+        }
+        
+        // Draw rounded rectangles around the controls
+        auto drawControlBackground = [&](const juce::Rectangle<float>& bounds)
+        {
+            g.setColour(accentColour.withAlpha(0.1f));
+            g.fillRoundedRectangle(bounds, 10.0f);
+            g.setColour(accentColour.withAlpha(0.2f));
+            g.drawRoundedRectangle(bounds, 10.0f, 1.0f);
+        };
+        
+        float controlWidth = getWidth() * 0.25f;
+        float controlHeight = controlWidth;
+        float yPos = getHeight() * 0.25f;
+        
+        // Draw backgrounds for each control
+        drawControlBackground(juce::Rectangle<float>(getWidth() * 0.1f, yPos, controlWidth, controlHeight));
+        drawControlBackground(juce::Rectangle<float>(getWidth() * 0.4f, yPos, controlWidth, controlHeight));
+        drawControlBackground(juce::Rectangle<float>(getWidth() * 0.7f, yPos, controlWidth, controlHeight));
+    });
 }
 
 void SimpleGainEditor::resized()
 {
+    renderBackground();
+    
     auto area = getLocalBounds().reduced(20);
     
     // Position the title at the top
@@ -170,8 +414,45 @@ void SimpleGainEditor::resized()
     modFreqLabel.setBounds(getWidth() * 0.4f, yPos, controlWidth, 30);
     modDepthLabel.setBounds(getWidth() * 0.7f, yPos, controlWidth, 30);
     
-    // Position the value label
+    // Position the shape and oversampling selectors below the controls
+    yPos += 50;
+    modShapeLabel.setBounds(getWidth() * 0.1f, yPos, controlWidth, 30);
+    modShapeBox.setBounds(getWidth() * 0.4f, yPos, getWidth() * 0.3f, 30);
+    oversamplingBox.setBounds(getWidth() * 0.72f, yPos, getWidth() * 0.23f, 30);
+    
+    // Position the meters below the shape selector
+    yPos += 42;
+    auto placeMeter = [&](LevelMeter& meter, juce::Label& label)
+    {
+        label.setBounds(getWidth() * 0.1f, yPos, getWidth() * 0.1f, 14);
+        meter.setBounds(getWidth() * 0.22f, yPos + 2, getWidth() * 0.73f, 10);
+        yPos += 18;
+    };
+    
+    placeMeter(inputMeter, inputMeterLabel);
+    placeMeter(outputMeter, outputMeterLabel);
+    placeMeter(modulationMeter, modulationMeterLabel);
+    
+    // Position the output stage row below the meters
+    yPos += 4;
+    clipModeBox.setBounds(getWidth() * 0.1f, yPos, getWidth() * 0.28f, 24);
+    ceilingSlider.setBounds(getWidth() * 0.4f, yPos, getWidth() * 0.4f, 24);
+    truePeakButton.setBounds(getWidth() * 0.82f, yPos, getWidth() * 0.13f, 24);
+    
+    // Position the stereo rows below the output stage
+    yPos += 28;
+    stereoModeBox.setBounds(getWidth() * 0.1f, yPos, getWidth() * 0.28f, 24);
+    stereoPhaseSlider.setBounds(getWidth() * 0.4f, yPos, getWidth() * 0.55f, 24);
+    
+    yPos += 28;
+    midGainLabel.setBounds(getWidth() * 0.1f, yPos, getWidth() * 0.08f, 24);
+    midGainSlider.setBounds(getWidth() * 0.18f, yPos, getWidth() * 0.32f, 24);
+    sideGainLabel.setBounds(getWidth() * 0.52f, yPos, getWidth() * 0.08f, 24);
+    sideGainSlider.setBounds(getWidth() * 0.6f, yPos, getWidth() * 0.35f, 24);
+    
+    // Position the value and DSP load labels
     valueLabel.setBounds(area.removeFromBottom(30));
+    performanceLabel.setBounds(area.removeFromBottom(20));
 }
 
 void SimpleGainEditor::sliderValueChanged(juce::Slider* slider)
@@ -180,16 +461,78 @@ void SimpleGainEditor::sliderValueChanged(juce::Slider* slider)
     juce::ignoreUnused(slider);
 }
 
+void SimpleGainEditor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    juce::ignoreUnused(parameterID, newValue);
+    valueTextDirty = true;
+}
+
 void SimpleGainEditor::timerCallback()
 {
-    // Update the value display
-    const float gainValue = gainSlider.getValue();
-    const float gainPercent = static_cast<float>(juce::Decibels::decibelsToGain(gainValue) * 100.0);
-    const float modFreq = modFreqSlider.getValue();
-    const float modDepth = modDepthSlider.getValue() * 100.0f;
-    
-    juce::String displayText = juce::String(gainValue, 1) + " dB, " + 
-                              juce::String(modFreq, 1) + " Hz, " +
-                              juce::String(modDepth, 1) + "%";
-    valueLabel.setText(displayText, juce::dontSendNotification);
-} 
\ No newline at end of file
+    // Update the value display only when something changed. The sliders follow changes from
+    // other threads asynchronously, so read the parameters rather than the sliders.
+    if (valueTextDirty.exchange(false))
+    {
+        auto& parameters = processor.getParameters();
+        const float gainValue = parameters.getRawParameterValue(SimpleGainProcessor::gainID)->load();
+        const float modFreq = parameters.getRawParameterValue(SimpleGainProcessor::modFreqID)->load();
+        const float modDepth = parameters.getRawParameterValue(SimpleGainProcessor::modDepthID)->load() * 100.0f;
+        
+        juce::String displayText = juce::String(gainValue, 1) + " dB, " + 
+                                  juce::String(modFreq, 1) + " Hz, " +
+                                  juce::String(modDepth, 1) + "%";
+        valueLabel.setText(displayText, juce::dontSendNotification);
+    }
+    
+    updateMeters();
+
+   #if SIMPLEGAIN_INSTRUMENTATION
+    // Update the DSP load display from the audio thread's timing records
+    if (++timerTicks % performanceUpdateInterval == 0)
+    {
+        auto& monitor = processor.getPerformanceMonitor();
+        monitor.update();
+        const auto stats = monitor.getStatistics();
+
+        performanceLabel.setText("DSP " + juce::String(stats.getAverageBudgetPercent(), 2) + "% avg, "
+                                     + juce::String(stats.maxBudgetPercent, 2) + "% max, "
+                                     + juce::String((juce::int64) stats.numOverruns) + " overruns",
+                                 juce::dontSendNotification);
+    }
+   #endif
+}
+
+void SimpleGainEditor::updateMeters()
+{
+    // Peaks fall back at about 45 dB/s at the 30 Hz timer rate
+    constexpr float peakDecayPerTick = 1.5f;
+    
+    const auto readings = processor.consumeMeterReadings();
+    auto toDecibels = [](float gain) { return juce::Decibels::gainToDecibels(gain, LevelMeter::minDecibels); };
+    
+    // With true-peak metering on, the output peak marker shows the inter-sample peak
+    const auto outputPeak = truePeakButton.getToggleState() ? juce::jmax(readings.outputPeak, readings.outputTruePeak)
+                                                            : readings.outputPeak;
+    
+    inputPeakHold = juce::jmax(toDecibels(readings.inputPeak), inputPeakHold - peakDecayPerTick);
+    outputPeakHold = juce::jmax(toDecibels(outputPeak), outputPeakHold - peakDecayPerTick);
+    
+    // Host blocks can be longer than a timer tick, so a tick without a new window keeps the
+    // last RMS and lets it fall like the peaks, only reaching the floor once audio stops
+    if (readings.hasNewData)
+    {
+        inputRmsLevel = toDecibels(readings.inputRms);
+        outputRmsLevel = toDecibels(readings.outputRms);
+    }
+    else
+    {
+        inputRmsLevel = juce::jmax(LevelMeter::minDecibels, inputRmsLevel - peakDecayPerTick);
+        outputRmsLevel = juce::jmax(LevelMeter::minDecibels, outputRmsLevel - peakDecayPerTick);
+    }
+
+    inputMeter.setLevels(inputPeakHold, inputRmsLevel);
+    outputMeter.setLevels(outputPeakHold, outputRmsLevel);
+    
+    const auto modulationDecibels = toDecibels(readings.modulationGain);
+    modulationMeter.setLevels(modulationDecibels, modulationDecibels);
+}
@@ -1,8 +1,17 @@
 #pragma once
 
 #include "PluginProcessor.h"
+#include "LevelMeter.h"
 #include <juce_graphics/juce_graphics.h>
 
+#ifndef SIMPLEGAIN_OPENGL_EDITOR
+ #define SIMPLEGAIN_OPENGL_EDITOR 0
+#endif
+
+#if SIMPLEGAIN_OPENGL_EDITOR
+ #include <juce_opengl/juce_opengl.h>
+#endif
+
 //==============================================================================
 /**
  * SimpleGainEditor provides the GUI for our gain plugin.
@@ -10,6 +19,7 @@
  */
 class SimpleGainEditor : public juce::AudioProcessorEditor,
                         private juce::Slider::Listener,
+                        private juce::AudioProcessorValueTreeState::Listener,
                         private juce::Timer
 {
 public:
@@ -22,37 +32,93 @@ public:
     void resized() override;
 
 private:
+    // Decoded images, renderings and fonts shared by every editor in the process
+    struct SharedAssets;
+    
     // Called when the slider value changes
     void sliderValueChanged(juce::Slider* slider) override;
     
+    // Called on any thread when a displayed parameter changes; only marks the text dirty
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    
+    // Pre-renders the background image and control panels at the current size
+    void renderBackground();
+    
     // Called regularly by the timer
     void timerCallback() override;
     
+    // Pulls the latest levels from the processor into the meters
+    void updateMeters();
+    
     // Reference to the processor
     SimpleGainProcessor& processor;
     
+    juce::SharedResourcePointer<SharedAssets> assets;
+    
     // GUI components
     juce::Slider gainSlider;
     juce::Slider modFreqSlider;
     juce::Slider modDepthSlider;
+    juce::ComboBox modShapeBox;
+    juce::ComboBox oversamplingBox;
+    juce::ComboBox clipModeBox;
+    juce::Slider ceilingSlider;
+    juce::ToggleButton truePeakButton;
+    juce::ComboBox stereoModeBox;
+    juce::Slider stereoPhaseSlider;
+    juce::Slider midGainSlider;
+    juce::Slider sideGainSlider;
     juce::Label gainLabel;
     juce::Label modFreqLabel;
     juce::Label modDepthLabel;
+    juce::Label modShapeLabel;
+    juce::Label midGainLabel;
+    juce::Label sideGainLabel;
     juce::Label titleLabel;
     juce::Label valueLabel;
+    juce::Label performanceLabel;
+    
+    // Level meters
+    LevelMeter inputMeter;
+    LevelMeter outputMeter;
+    LevelMeter modulationMeter;
+    juce::Label inputMeterLabel;
+    juce::Label outputMeterLabel;
+    juce::Label modulationMeterLabel;
+    float inputPeakHold = LevelMeter::minDecibels;
+    float outputPeakHold = LevelMeter::minDecibels;
+    float inputRmsLevel = LevelMeter::minDecibels;
+    float outputRmsLevel = LevelMeter::minDecibels;
     
     // Parameter attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gainAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> modFreqAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> modDepthAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> modShapeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> clipModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> ceilingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> truePeakAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> stereoModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> stereoPhaseAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> midGainAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> sideGainAttachment;
     
     // Colors
     juce::Colour backgroundColour = juce::Colour(30, 30, 30);
     juce::Colour accentColour = juce::Colour(42, 128, 185);
     juce::Colour textColour = juce::Colour(225, 225, 225);
     
-    // Background image
-    juce::Image backgroundImage;
+    // The background plus static chrome rendered at the editor's size
+    juce::Image cachedBackground;
+    
+    // Set when a displayed parameter changes, so the timer only rebuilds text when needed
+    std::atomic<bool> valueTextDirty { true };
+    int timerTicks = 0;
+    
+   #if SIMPLEGAIN_OPENGL_EDITOR
+    juce::OpenGLContext openGLContext;
+   #endif
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SimpleGainEditor)
 }; 
\ No newline at end of file
@@ -1,10 +1,58 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "GainKernels.h"
 
 //==============================================================================
 const juce::String SimpleGainProcessor::gainID = "gain";
-const juce::String SimpleGainProcessor::modFreqID = "modfreq";
+const juce::String SimpleGainProcessor::modFreqID = "modrate";
 const juce::String SimpleGainProcessor::modDepthID = "moddepth";
+const juce::String SimpleGainProcessor::modShapeID = "modshape";
+const juce::String SimpleGainProcessor::oversamplingID = "oversampling";
+const juce::String SimpleGainProcessor::clipModeID = "clipmode";
+const juce::String SimpleGainProcessor::ceilingID = "ceiling";
+const juce::String SimpleGainProcessor::truePeakID = "truepeak";
+const juce::String SimpleGainProcessor::stereoModeID = "stereomode";
+const juce::String SimpleGainProcessor::stereoPhaseID = "stereophase";
+const juce::String SimpleGainProcessor::midGainID = "midgain";
+const juce::String SimpleGainProcessor::sideGainID = "sidegain";
+
+namespace
+{
+    // Ramp lengths used when the host or UI moves a parameter
+    constexpr double gainRampSeconds = 0.02;
+    constexpr double modDepthRampSeconds = 0.02;
+    constexpr double modFreqRampSeconds = 0.05;
+    constexpr double stereoPhaseRampSeconds = 0.05;
+    constexpr double midSideGainRampSeconds = 0.02;
+
+    // While the rate or the stereo phase ramps, the LFO pair is rendered in runs this long
+    constexpr int stereoLfoRunLength = 16;
+
+    // Slow LFOs are evaluated every few samples and interpolated, as long as
+    // that still leaves plenty of control points per cycle
+    constexpr int lfoControlRateInterval = 16;
+    constexpr double minControlPointsPerCycle = 64.0;
+
+    // Tremolo rates never engage the oversampler; audio-rate modulation does.
+    // The gap between the two keeps it from toggling around a single threshold.
+    constexpr float oversamplingEngageHz = 50.0f;
+    constexpr float oversamplingReleaseHz = 40.0f;
+
+    // Outputs that would stay below -120 dBFS on every channel count as silence
+    constexpr float silenceThreshold = 1.0e-6f;
+
+    // The rate used to be a linear 0.1-10 Hz parameter under this ID. Hosts store automation
+    // normalised, so the wider range has its own ID rather than reinterpreting old lanes.
+    const juce::String legacyModFreqID = "modfreq";
+
+    // Half of the knob covers the tremolo range, the other half goes up to audio rate
+    juce::NormalisableRange<float> makeModFreqRange()
+    {
+        juce::NormalisableRange<float> range(0.1f, 20000.0f, 0.01f);
+        range.setSkewForCentre(10.0f);
+        return range;
+    }
+}
 
 SimpleGainProcessor::SimpleGainProcessor()
     : AudioProcessor(BusesProperties()
@@ -21,9 +69,9 @@ SimpleGainProcessor::SimpleGainProcessor()
                             .withLabel("dB")
                             .withCategory(juce::AudioParameterFloat::genericParameter)),
                     std::make_unique<juce::AudioParameterFloat>(
-                        juce::ParameterID(modFreqID, 1),
+                        juce::ParameterID(modFreqID, 2),
                         "Mod Freq",
-                        juce::NormalisableRange<float>(0.1f, 10.0f, 0.1f),
+                        makeModFreqRange(),
                         1.0f,
                         juce::AudioParameterFloatAttributes()
                             .withLabel("Hz")
@@ -35,6 +83,62 @@ SimpleGainProcessor::SimpleGainProcessor()
                         0.0f,
                         juce::AudioParameterFloatAttributes()
                             .withLabel("%")
+                            .withCategory(juce::AudioParameterFloat::genericParameter)),
+                    std::make_unique<juce::AudioParameterChoice>(
+                        juce::ParameterID(modShapeID, 1),
+                        "Mod Shape",
+                        juce::StringArray { "Sine", "Triangle", "Saw", "Square", "Sample & Hold" },
+                        0),
+                    std::make_unique<juce::AudioParameterChoice>(
+                        juce::ParameterID(oversamplingID, 1),
+                        "Oversampling",
+                        juce::StringArray { "Off", "2x", "4x", "8x" },
+                        0),
+                    std::make_unique<juce::AudioParameterChoice>(
+                        juce::ParameterID(clipModeID, 1),
+                        "Clip Mode",
+                        juce::StringArray { "Off", "Soft Clip", "Hard Clip" },
+                        0),
+                    std::make_unique<juce::AudioParameterFloat>(
+                        juce::ParameterID(ceilingID, 1),
+                        "Ceiling",
+                        juce::NormalisableRange<float>(-24.0f, 0.0f, 0.1f),
+                        0.0f,
+                        juce::AudioParameterFloatAttributes()
+                            .withLabel("dB")
+                            .withCategory(juce::AudioParameterFloat::genericParameter)),
+                    std::make_unique<juce::AudioParameterBool>(
+                        juce::ParameterID(truePeakID, 1),
+                        "True Peak Meter",
+                        false),
+                    std::make_unique<juce::AudioParameterChoice>(
+                        juce::ParameterID(stereoModeID, 1),
+                        "Stereo Mode",
+                        juce::StringArray { "Left/Right", "Mid/Side" },
+                        0),
+                    std::make_unique<juce::AudioParameterFloat>(
+                        juce::ParameterID(stereoPhaseID, 1),
+                        "Stereo Phase",
+                        juce::NormalisableRange<float>(0.0f, 180.0f, 1.0f),
+                        0.0f,
+                        juce::AudioParameterFloatAttributes()
+                            .withLabel("deg")
+                            .withCategory(juce::AudioParameterFloat::genericParameter)),
+                    std::make_unique<juce::AudioParameterFloat>(
+                        juce::ParameterID(midGainID, 1),
+                        "Mid Gain",
+                        juce::NormalisableRange<float>(-24.0f, 12.0f, 0.1f),
+                        0.0f,
+                        juce::AudioParameterFloatAttributes()
+                            .withLabel("dB")
+                            .withCategory(juce::AudioParameterFloat::genericParameter)),
+                    std::make_unique<juce::AudioParameterFloat>(
+                        juce::ParameterID(sideGainID, 1),
+                        "Side Gain",
+                        juce::NormalisableRange<float>(-24.0f, 12.0f, 0.1f),
+                        0.0f,
+                        juce::AudioParameterFloatAttributes()
+                            .withLabel("dB")
                             .withCategory(juce::AudioParameterFloat::genericParameter))
                 })
 {
@@ -42,45 +146,361 @@ SimpleGainProcessor::SimpleGainProcessor()
     parameters.addParameterListener(gainID, this);
     parameters.addParameterListener(modFreqID, this);
     parameters.addParameterListener(modDepthID, this);
+    parameters.addParameterListener(modShapeID, this);
+    parameters.addParameterListener(oversamplingID, this);
+    parameters.addParameterListener(clipModeID, this);
+    parameters.addParameterListener(ceilingID, this);
+    parameters.addParameterListener(truePeakID, this);
+    parameters.addParameterListener(stereoModeID, this);
+    parameters.addParameterListener(stereoPhaseID, this);
+    parameters.addParameterListener(midGainID, this);
+    parameters.addParameterListener(sideGainID, this);
+
+    stateParameters = { parameters.getParameter(gainID),
+                        parameters.getParameter(modFreqID),
+                        parameters.getParameter(modDepthID),
+                        parameters.getParameter(modShapeID),
+                        parameters.getParameter(oversamplingID),
+                        parameters.getParameter(clipModeID),
+                        parameters.getParameter(ceilingID),
+                        parameters.getParameter(truePeakID),
+                        parameters.getParameter(stereoModeID),
+                        parameters.getParameter(stereoPhaseID),
+                        parameters.getParameter(midGainID),
+                        parameters.getParameter(sideGainID) };
     
     // Initialize parameter values
-    if (auto* param = parameters.getParameter(gainID))
-        currentGain = juce::Decibels::decibelsToGain(param->getValue());
-    if (auto* param = parameters.getParameter(modFreqID))
-        currentModFreq = param->getValue();
-    if (auto* param = parameters.getParameter(modDepthID))
-        currentModDepth = param->getValue();
-        
-    // Initialize oscillator
-    modulator.initialise([](float x) { return std::sin(x); });
+    if (auto* value = parameters.getRawParameterValue(gainID))
+        currentGain = juce::Decibels::decibelsToGain(value->load());
+    if (auto* value = parameters.getRawParameterValue(modFreqID))
+        currentModFreq = value->load();
+    if (auto* value = parameters.getRawParameterValue(modDepthID))
+        currentModDepth = value->load();
+    if (auto* value = parameters.getRawParameterValue(modShapeID))
+        currentModShape = juce::roundToInt(value->load());
+    if (auto* value = parameters.getRawParameterValue(oversamplingID))
+        currentOversampling = juce::roundToInt(value->load());
+    if (auto* value = parameters.getRawParameterValue(clipModeID))
+        currentClipMode = juce::roundToInt(value->load());
+    if (auto* value = parameters.getRawParameterValue(ceilingID))
+        currentCeiling = juce::Decibels::decibelsToGain(value->load());
+    if (auto* value = parameters.getRawParameterValue(truePeakID))
+        currentTruePeak = value->load() >= 0.5f;
+    if (auto* value = parameters.getRawParameterValue(stereoModeID))
+        currentStereoMode = juce::roundToInt(value->load());
+    if (auto* value = parameters.getRawParameterValue(stereoPhaseID))
+        currentStereoPhase = toEventValue(stereoPhaseIndex, value->load());
+    if (auto* value = parameters.getRawParameterValue(midGainID))
+        currentMidGain = juce::Decibels::decibelsToGain(value->load());
+    if (auto* value = parameters.getRawParameterValue(sideGainID))
+        currentSideGain = juce::Decibels::decibelsToGain(value->load());
 }
 
 SimpleGainProcessor::~SimpleGainProcessor()
 {
+    cancelPendingUpdate();
     parameters.removeParameterListener(gainID, this);
     parameters.removeParameterListener(modFreqID, this);
     parameters.removeParameterListener(modDepthID, this);
+    parameters.removeParameterListener(modShapeID, this);
+    parameters.removeParameterListener(oversamplingID, this);
+    parameters.removeParameterListener(clipModeID, this);
+    parameters.removeParameterListener(ceilingID, this);
+    parameters.removeParameterListener(truePeakID, this);
+    parameters.removeParameterListener(stereoModeID, this);
+    parameters.removeParameterListener(stereoPhaseID, this);
+    parameters.removeParameterListener(midGainID, this);
+    parameters.removeParameterListener(sideGainID, this);
+
+   #if SIMPLEGAIN_INSTRUMENTATION
+    // Headless and standalone runs can ask for a timing report on exit
+    const auto reportPath = juce::SystemStats::getEnvironmentVariable("SIMPLEGAIN_PERF_REPORT", {});
+
+    if (reportPath.isNotEmpty())
+        performanceMonitor.writeReport(juce::File::getCurrentWorkingDirectory().getChildFile(reportPath));
+   #endif
 }
 
 //==============================================================================
 void SimpleGainProcessor::parameterChanged(const juce::String& parameterID, float newValue)
 {
+    // Called on the UI, automation or audio thread: store the latest value and queue
+    // an event for the audio thread. Nothing here touches the DSP state.
+    // While a program is copied into the parameters, its own event already carries
+    // every value, so the echoes from the message thread aren't queued again.
+    const auto isProgramEcho = juce::MessageManager::existsAndIsCurrentThread() && isApplyingProgram;
+
+    auto queue = [this, isProgramEcho](int parameterIndex, float value)
+    {
+        if (! isProgramEcho)
+            parameterEvents.push(parameterIndex, value);
+    };
+
     if (parameterID == gainID)
     {
         currentGain = juce::Decibels::decibelsToGain(newValue);
+        queue(gainIndex, currentGain);
     }
     else if (parameterID == modFreqID)
     {
         currentModFreq = newValue;
-        if (currentSampleRate > 0)
-            modulator.setFrequency(currentModFreq);
+        queue(modFreqIndex, newValue);
     }
     else if (parameterID == modDepthID)
     {
         currentModDepth = newValue;
+        queue(modDepthIndex, newValue);
+    }
+    else if (parameterID == modShapeID)
+    {
+        currentModShape = juce::roundToInt(newValue);
+        queue(modShapeIndex, (float) currentModShape.load());
+    }
+    else if (parameterID == oversamplingID)
+    {
+        currentOversampling = juce::roundToInt(newValue);
+        queue(oversamplingIndex, (float) currentOversampling.load());
+
+        // The compensation delay follows the factor, even while the oversampler is idle
+        updateLatency();
+    }
+    else if (parameterID == clipModeID)
+    {
+        currentClipMode = juce::roundToInt(newValue);
+        queue(clipModeIndex, (float) currentClipMode.load());
+    }
+    else if (parameterID == ceilingID)
+    {
+        currentCeiling = juce::Decibels::decibelsToGain(newValue);
+        queue(ceilingIndex, currentCeiling);
+    }
+    else if (parameterID == truePeakID)
+    {
+        currentTruePeak = newValue >= 0.5f;
+        queue(truePeakIndex, currentTruePeak ? 1.0f : 0.0f);
+    }
+    else if (parameterID == stereoModeID)
+    {
+        currentStereoMode = juce::roundToInt(newValue);
+        queue(stereoModeIndex, (float) currentStereoMode.load());
+    }
+    else if (parameterID == stereoPhaseID)
+    {
+        currentStereoPhase = toEventValue(stereoPhaseIndex, newValue);
+        queue(stereoPhaseIndex, currentStereoPhase);
+    }
+    else if (parameterID == midGainID)
+    {
+        currentMidGain = juce::Decibels::decibelsToGain(newValue);
+        queue(midGainIndex, currentMidGain);
+    }
+    else if (parameterID == sideGainID)
+    {
+        currentSideGain = juce::Decibels::decibelsToGain(newValue);
+        queue(sideGainIndex, currentSideGain);
+    }
+}
+
+void SimpleGainProcessor::applyQueuedParameterEvents() noexcept
+{
+    const auto numEvents = parameterEvents.pop(blockEvents.data(), (int) blockEvents.size());
+
+    // Events were dropped, so the queue no longer tells the whole story
+    if (parameterEvents.checkAndClearOverflow())
+    {
+        syncParametersFromAtomics();
+        return;
+    }
+
+    // Hosts deliver automation just before the block it belongs to, without a position
+    // inside it, so every change starts at the first sample and the smoothers ramp from there
+    for (int i = 0; i < numEvents; ++i)
+        applyParameterEvent(blockEvents[(size_t) i]);
+}
+
+void SimpleGainProcessor::applyParameterEvent(const ParameterEvent& event) noexcept
+{
+    switch (event.parameterIndex)
+    {
+        case gainIndex:
+            gainSmoother.setTargetValue(event.value);
+            break;
+
+        case modFreqIndex:
+            modFreqSmoother.setTargetValue(event.value);
+            updateLfoControlRate();
+            break;
+
+        case modDepthIndex:
+            modDepthSmoother.setTargetValue(event.value);
+            break;
+
+        case modShapeIndex:
+            modulator.setShape((ModulationLfo::Shape) juce::roundToInt(event.value));
+            break;
+
+        case oversamplingIndex:
+            oversampler.setChoice(juce::roundToInt(event.value));
+            doubleOversampler.setChoice(juce::roundToInt(event.value));
+            break;
+
+        case clipModeIndex:
+            outputStage.mode = (GainKernels::OutputStage::Mode) juce::jlimit(0, 2, juce::roundToInt(event.value));
+            break;
+
+        case ceilingIndex:
+            outputStage.ceiling = event.value;
+            break;
+
+        case truePeakIndex:
+            // Start from a clean history rather than whatever was there when it was last on
+            if (event.value >= 0.5f && ! truePeakEnabled)
+                truePeakMeter.reset();
+
+            truePeakEnabled = event.value >= 0.5f;
+            break;
+
+        case stereoModeIndex:
+            midSideMode = juce::roundToInt(event.value) == 1;
+            break;
+
+        case stereoPhaseIndex:
+            stereoPhaseSmoother.setTargetValue(event.value);
+            break;
+
+        case midGainIndex:
+            midGainSmoother.setTargetValue(event.value);
+            break;
+
+        case sideGainIndex:
+            sideGainSmoother.setTargetValue(event.value);
+            break;
+
+        case programIndex:
+            applyProgram(juce::roundToInt(event.value));
+            break;
+
+        default:
+            break;
+    }
+}
+
+void SimpleGainProcessor::applyProgram(int index) noexcept
+{
+    // Reads the shared snapshot in place: the smoothers ramp gain, depth, rate, stereo
+    // phase and the mid/side gains to it. The LFO shape, stereo mode, clip mode and
+    // oversampling factor switch at once, as they do when automated, so a program that
+    // changes one of them mid-playback can click.
+    auto* values = presetBank->getValues(index);
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        ParameterEvent event;
+        event.parameterIndex = i;
+        event.value = toEventValue(i, values[i]);
+        applyParameterEvent(event);
+    }
+}
+
+float SimpleGainProcessor::toEventValue(int parameterIndex, float plainValue) noexcept
+{
+    switch (parameterIndex)
+    {
+        case gainIndex:
+        case ceilingIndex:
+        case midGainIndex:
+        case sideGainIndex:
+            return juce::Decibels::decibelsToGain(plainValue);
+
+        case stereoPhaseIndex:
+            return plainValue / 360.0f;
+
+        default:
+            return plainValue;
     }
 }
 
+void SimpleGainProcessor::syncParametersFromAtomics() noexcept
+{
+    gainSmoother.setTargetValue(currentGain.load());
+    modDepthSmoother.setTargetValue(currentModDepth.load());
+    modFreqSmoother.setTargetValue(currentModFreq.load());
+    modulator.setShape((ModulationLfo::Shape) currentModShape.load());
+    oversampler.setChoice(currentOversampling);
+    doubleOversampler.setChoice(currentOversampling);
+    outputStage.mode = (GainKernels::OutputStage::Mode) juce::jlimit(0, 2, currentClipMode.load());
+    outputStage.ceiling = currentCeiling;
+    truePeakEnabled = currentTruePeak;
+    midSideMode = currentStereoMode == 1;
+    stereoPhaseSmoother.setTargetValue(currentStereoPhase.load());
+    midGainSmoother.setTargetValue(currentMidGain.load());
+    sideGainSmoother.setTargetValue(currentSideGain.load());
+    updateLfoControlRate();
+}
+
+void SimpleGainProcessor::updateLfoControlRate() noexcept
+{
+    const auto useControlRate = modFreqSmoother.getTargetValue() * lfoControlRateInterval * minControlPointsPerCycle
+                                    <= currentSampleRate;
+    modulator.setControlRateInterval(useControlRate ? lfoControlRateInterval : 1);
+}
+
+//==============================================================================
+void SimpleGainProcessor::publishMeterReadings() noexcept
+{
+    auto& window = pendingMeterWindow;
+    window.inputPeak = juce::jmax(window.inputPeak, (float) blockInputLevels.peak);
+    window.outputPeak = juce::jmax(window.outputPeak, (float) blockOutputLevels.peak);
+    window.outputTruePeak = juce::jmax(window.outputTruePeak, blockTruePeak);
+    window.inputSumSquares += blockInputLevels.sumSquares;
+    window.outputSumSquares += blockOutputLevels.sumSquares;
+    window.numSamples += blockInputLevels.numSamples;
+    meterModulationGain.store(lastEnvelopeGain, std::memory_order_relaxed);
+
+    // Hand the window over once the editor has taken the previous one; until then keep adding to it
+    if (! meterWindowReady.load(std::memory_order_acquire))
+    {
+        publishedMeterWindow = window;
+        window = {};
+        meterWindowReady.store(true, std::memory_order_release);
+    }
+}
+
+SimpleGainProcessor::MeterReadings SimpleGainProcessor::consumeMeterReadings() noexcept
+{
+    MeterReadings readings;
+    readings.modulationGain = meterModulationGain.load(std::memory_order_relaxed);
+
+    if (! meterWindowReady.load(std::memory_order_acquire))
+        return readings;
+
+    // Every value comes from the same window, so RMS always divides matching sums and counts
+    const auto window = publishedMeterWindow;
+    meterWindowReady.store(false, std::memory_order_release);
+
+    readings.inputPeak = window.inputPeak;
+    readings.outputPeak = window.outputPeak;
+    readings.outputTruePeak = window.outputTruePeak;
+
+    if (window.numSamples > 0)
+    {
+        readings.inputRms = (float) std::sqrt(window.inputSumSquares / (double) window.numSamples);
+        readings.outputRms = (float) std::sqrt(window.outputSumSquares / (double) window.numSamples);
+        readings.hasNewData = true;
+    }
+
+    return readings;
+}
+
+void SimpleGainProcessor::setMeteringEnabled(bool shouldMeter) noexcept
+{
+    // Called by the consumer: a window left over from the last time the meters were shown is stale
+    if (shouldMeter)
+        meterWindowReady.store(false, std::memory_order_release);
+
+    meteringEnabled = shouldMeter;
+}
+
 //==============================================================================
 const juce::String SimpleGainProcessor::getName() const
 {
@@ -104,42 +524,169 @@ bool SimpleGainProcessor::isMidiEffect() const
 
 double SimpleGainProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // Gain and modulation stop with the input; only the oversampling filters ring on
+    const auto sampleRate = getSampleRate();
+    const auto tailSamples = 2 * oversamplingLatencies[(size_t) currentOversampling.load()].load();
+
+    return sampleRate > 0.0 ? tailSamples / sampleRate : 0.0;
 }
 
 int SimpleGainProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return presetBank->getNumPresets();
 }
 
 int SimpleGainProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void SimpleGainProcessor::setCurrentProgram(int index)
 {
-    juce::ignoreUnused(index);
+    if (index < 0 || index >= presetBank->getNumPresets())
+        return;
+
+    // The snapshot is already decoded, so switching is a handful of atomic stores. The
+    // audio thread picks it up from the event queue, in order with any automation, and
+    // ramps to it. VST3 hosts can switch from process(), so the parameter objects are only
+    // updated here on the message thread; otherwise handleAsyncUpdate catches them up.
+    auto* values = presetBank->getValues(index);
+    currentProgram = index;
+    currentGain = juce::Decibels::decibelsToGain(values[gainIndex]);
+    currentModFreq = values[modFreqIndex];
+    currentModDepth = values[modDepthIndex];
+    currentModShape = juce::roundToInt(values[modShapeIndex]);
+    currentOversampling = juce::roundToInt(values[oversamplingIndex]);
+    currentClipMode = juce::roundToInt(values[clipModeIndex]);
+    currentCeiling = juce::Decibels::decibelsToGain(values[ceilingIndex]);
+    currentTruePeak = values[truePeakIndex] >= 0.5f;
+    currentStereoMode = juce::roundToInt(values[stereoModeIndex]);
+    currentStereoPhase = toEventValue(stereoPhaseIndex, values[stereoPhaseIndex]);
+    currentMidGain = toEventValue(midGainIndex, values[midGainIndex]);
+    currentSideGain = toEventValue(sideGainIndex, values[sideGainIndex]);
+
+    parameterEvents.push(programIndex, (float) index);
+    updateLatency();
+
+    if (juce::MessageManager::existsAndIsCurrentThread())
+    {
+        programUpdatePending = false;
+        updateParametersFromProgram();
+    }
+    else
+    {
+        programUpdatePending = true;
+        triggerAsyncUpdate();
+    }
 }
 
 const juce::String SimpleGainProcessor::getProgramName(int index)
 {
-    juce::ignoreUnused(index);
-    return {};
+    return presetBank->getName(index);
 }
 
 void SimpleGainProcessor::changeProgramName(int index, const juce::String& newName)
 {
+    // The bank is shared and read-only
     juce::ignoreUnused(index, newName);
 }
 
+void SimpleGainProcessor::updateParametersFromProgram()
+{
+    auto* values = presetBank->getValues(currentProgram);
+    const juce::ScopedValueSetter<bool> applying(isApplyingProgram, true);
+
+    // Only parameters that actually differ are touched, so these round trips are cheap
+    for (size_t i = 0; i < stateParameters.size(); ++i)
+    {
+        auto* parameter = stateParameters[i];
+        const auto newValue = parameter->convertTo0to1(values[i]);
+
+        if (parameter->getValue() != newValue)
+            parameter->setValueNotifyingHost(newValue);
+    }
+}
+
+void SimpleGainProcessor::updateLatency() noexcept
+{
+    // Automation can arrive on the audio thread, where the host mustn't be called back
+    if (juce::MessageManager::existsAndIsCurrentThread())
+    {
+        latencyChangePending = false;
+        setLatencySamples(oversamplingLatencies[(size_t) currentOversampling.load()]);
+    }
+    else
+    {
+        latencyChangePending = true;
+        triggerAsyncUpdate();
+    }
+}
+
+void SimpleGainProcessor::handleAsyncUpdate()
+{
+    if (latencyChangePending.exchange(false))
+        setLatencySamples(oversamplingLatencies[(size_t) currentOversampling.load()]);
+
+    if (programUpdatePending.exchange(false))
+        updateParametersFromProgram();
+}
+
 //==============================================================================
 void SimpleGainProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
     currentSampleRate = sampleRate;
-    modulator.prepare({ sampleRate, (juce::uint32) samplesPerBlock, 1 });
+    performanceMonitor.prepare(sampleRate);
+    modulator.prepare(sampleRate);
     modulator.setFrequency(currentModFreq);
+
+    gainSmoother.reset(sampleRate, gainRampSeconds);
+    gainSmoother.setCurrentAndTargetValue(currentGain);
+    modDepthSmoother.reset(sampleRate, modDepthRampSeconds);
+    modDepthSmoother.setCurrentAndTargetValue(currentModDepth);
+    modFreqSmoother.reset(sampleRate, modFreqRampSeconds);
+    modFreqSmoother.setCurrentAndTargetValue(currentModFreq);
+    stereoPhaseSmoother.reset(sampleRate, stereoPhaseRampSeconds);
+    stereoPhaseSmoother.setCurrentAndTargetValue(currentStereoPhase);
+    midGainSmoother.reset(sampleRate, midSideGainRampSeconds);
+    midGainSmoother.setCurrentAndTargetValue(currentMidGain);
+    sideGainSmoother.reset(sampleRate, midSideGainRampSeconds);
+    sideGainSmoother.setCurrentAndTargetValue(currentSideGain);
+    modulator.setPhaseOffset(currentStereoPhase);
+
+    // The atomics already hold the latest values, so anything still queued is stale
+    while (parameterEvents.pop(blockEvents.data(), (int) blockEvents.size()) > 0) {}
+    parameterEvents.checkAndClearOverflow();
+    silentInputSamples = 0;
+    truePeakMeter.reset();
+    syncParametersFromAtomics();
+
+    // Preallocate the envelope and the oversampling filters so processBlock never allocates
+    const auto maxBlockSize = juce::jmax(1, samplesPerBlock);
+    const auto envelopeSize = maxBlockSize * ModulationOversampler<float>::maxFactor;
+    const auto numChannels = getTotalNumInputChannels();
+
+    if (isUsingDoublePrecision())
+    {
+        doubleEnvelopeBuffer.setSize(2, envelopeSize);
+        envelopeBuffer.setSize(0, 0);
+        doubleOversampler.prepare(numChannels, maxBlockSize);
+        oversampler.release();
+    }
+    else
+    {
+        envelopeBuffer.setSize(2, envelopeSize);
+        doubleEnvelopeBuffer.setSize(0, 0);
+        oversampler.prepare(numChannels, maxBlockSize);
+        doubleOversampler.release();
+    }
+
+    // The FIR latencies only depend on the factor, so either precision can report them
+    for (int choice = 0; choice < ModulationOversampler<float>::numChoices; ++choice)
+        oversamplingLatencies[(size_t) choice] = isUsingDoublePrecision() ? doubleOversampler.getLatencySamples(choice)
+                                                                          : oversampler.getLatencySamples(choice);
+
+    modulator.setOversamplingFactor(1);
+    setLatencySamples(oversamplingLatencies[(size_t) currentOversampling.load()]);
 }
 
 void SimpleGainProcessor::releaseResources()
@@ -151,9 +698,10 @@ void SimpleGainProcessor::releaseResources()
 bool SimpleGainProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
     // This is the place where you check if the layout is supported.
-    // We support mono and stereo.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // We support any discrete, surround or ambisonic layout up to maxNumChannels.
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+
+    if (numChannels == 0 || numChannels > maxNumChannels)
         return false;
 
     // We require the same number of input and output channels
@@ -166,6 +714,38 @@ bool SimpleGainProcessor::isBusesLayoutSupported(const BusesLayout& layouts) con
 void SimpleGainProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused(midiMessages);
+    processSamples(buffer, envelopeBuffer);
+}
+
+void SimpleGainProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer, doubleEnvelopeBuffer);
+}
+
+void SimpleGainProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processBypassedSamples(buffer, envelopeBuffer);
+}
+
+void SimpleGainProcessor::processBlockBypassed(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processBypassedSamples(buffer, doubleEnvelopeBuffer);
+}
+
+bool SimpleGainProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void SimpleGainProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer, juce::AudioBuffer<SampleType>& envelopeScratch)
+{
+   #if SIMPLEGAIN_INSTRUMENTATION
+    const PerformanceMonitor::ScopedBlockTimer blockTimer(performanceMonitor, buffer.getNumSamples());
+   #endif
 
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels = getTotalNumInputChannels();
@@ -175,27 +755,487 @@ void SimpleGainProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::M
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    // Process each channel
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    const auto numSamples = buffer.getNumSamples();
+    const auto maxChunk = envelopeScratch.getNumSamples() / ModulationOversampler<SampleType>::maxFactor;
+
+    // Not prepared yet, or prepared for the other precision
+    if (maxChunk == 0)
+        return;
+
+    auto* envelopes = envelopeScratch.getArrayOfWritePointers();
+
+    const auto wasMeteringBlock = isMeteringBlock;
+    isMeteringBlock = meteringEnabled.load(std::memory_order_relaxed);
+
+    // Nothing is measured while nobody is looking, so the true-peak history and the level
+    // window start afresh rather than carrying on from when metering stopped
+    if (isMeteringBlock && ! wasMeteringBlock)
+    {
+        truePeakMeter.reset();
+        pendingMeterWindow = {};
+    }
+
+    blockInputLevels = {};
+    blockOutputLevels = {};
+
+    applyQueuedParameterEvents();
+    processSegment(buffer, envelopes, maxChunk, 0, numSamples, totalNumInputChannels);
+
+    if (isMeteringBlock)
     {
-        auto* channelData = buffer.getWritePointer(channel);
+        // Interpolated at 4x, so it needs the finished output rather than a place in the tile pass
+        blockTruePeak = 0.0f;
 
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+        if (truePeakEnabled)
+            for (int channel = 0; channel < totalNumInputChannels; ++channel)
+                blockTruePeak = juce::jmax(blockTruePeak, truePeakMeter.process(channel, buffer.getReadPointer(channel), numSamples));
+
+        publishMeterReadings();
+    }
+}
+
+template <typename SampleType>
+void SimpleGainProcessor::processBypassedSamples(juce::AudioBuffer<SampleType>& buffer,
+                                                 const juce::AudioBuffer<SampleType>& envelopeScratch)
+{
+    const auto numInputChannels = getTotalNumInputChannels();
+
+    for (auto i = numInputChannels; i < getTotalNumOutputChannels(); ++i)
+        buffer.clear(i, 0, buffer.getNumSamples());
+
+    silentInputSamples = 0;
+
+    // Without oversampling there is no latency, so the input already is the output.
+    // Otherwise the oversampler delays it, or drains its filters first if they were in use.
+    auto& activeOversampler = getOversampler<SampleType>();
+    const auto maxChunk = envelopeScratch.getNumSamples() / ModulationOversampler<SampleType>::maxFactor;
+
+    if (maxChunk == 0 || activeOversampler.getLatencySamples() == 0)
+        return;
+
+    for (int start = 0; start < buffer.getNumSamples(); start += maxChunk)
+        activeOversampler.processBypassed(buffer.getArrayOfWritePointers(), numInputChannels, start,
+                                          juce::jmin(maxChunk, buffer.getNumSamples() - start));
+}
+
+template <typename SampleType>
+void SimpleGainProcessor::processSegment(juce::AudioBuffer<SampleType>& buffer, SampleType* const* envelopes, int maxChunk,
+                                         int startSample, int numSamples, int numChannels)
+{
+    auto& activeOversampler = getOversampler<SampleType>();
+    auto& gainKernels = kernels.get<SampleType>();
+
+    // Hosts may send blocks larger than announced in prepareToPlay, so work in chunks
+    for (int start = startSample; start < startSample + numSamples; start += maxChunk)
+    {
+        const auto chunkSize = juce::jmin(maxChunk, startSample + numSamples - start);
+        const auto isModulated = modDepthSmoother.isSmoothing() || modDepthSmoother.getTargetValue() > 0.0f;
+
+        // Idle tracks: once the input has been silent for longer than the oversampling
+        // filters ring, the output is silent too and nothing needs computing. Silence is
+        // judged after the largest gain the envelope can reach, so boosted quiet tails still pass.
+        const auto inputThreshold = silenceThreshold / juce::jmax(1.0e-12f, getPeakEnvelopeGain(isModulated, numChannels));
+
+        if (gainKernels.isSilent(buffer.getArrayOfReadPointers(), numChannels, start, chunkSize, (SampleType) inputThreshold))
         {
-            // Get modulation value (-1 to 1)
-            float modValue = modulator.processSample(0.0f);
-            
-            // Scale modulation by depth (0 to 1)
-            modValue *= currentModDepth;
-            
-            // Apply modulation and gain
-            float inputSample = channelData[sample];
-            float modulatedSample = inputSample * (1.0f + modValue);
-            channelData[sample] = modulatedSample * currentGain;
+            const auto canSkip = silentInputSamples >= activeOversampler.getTailSamples();
+            silentInputSamples += chunkSize;
+
+            if (canSkip)
+            {
+                skipSilentSamples(buffer, start, chunkSize, numChannels, isModulated);
+                continue;
+            }
+        }
+        else
+        {
+            silentInputSamples = 0;
         }
+
+        // Stereo buses only leave the shared envelope when the channels actually differ
+        const auto isStereo = numChannels == 2 && needsStereoProcessing(isModulated);
+
+        if (! isStereo)
+            skipStereoSmoothers(chunkSize);
+
+        const auto oversamplingThreshold = activeOversampler.isEngaged() ? oversamplingReleaseHz : oversamplingEngageHz;
+
+        // Only audio-rate modulation pays for oversampling
+        if (isModulated && activeOversampler.isAvailable() && modFreqSmoother.getCurrentValue() >= oversamplingThreshold)
+        {
+            processOversampledKernel(buffer.getArrayOfWritePointers(), envelopes, start, chunkSize, numChannels, isStereo);
+            continue;
+        }
+
+        modulator.setOversamplingFactor(1);
+
+        if (isStereo)
+            processKernel<KernelType::stereo>(buffer, envelopes, start, chunkSize, numChannels);
+        else if (isModulated)
+            processKernel<KernelType::modulated>(buffer, envelopes, start, chunkSize, numChannels);
+        else if (gainSmoother.isSmoothing())
+            processKernel<KernelType::rampingGain>(buffer, envelopes, start, chunkSize, numChannels);
+        else if (gainSmoother.getTargetValue() != 1.0f || outputStage.isActive())
+            processKernel<KernelType::staticGain>(buffer, envelopes, start, chunkSize, numChannels);
+        else
+            processKernel<KernelType::passthrough>(buffer, envelopes, start, chunkSize, numChannels);
+
+        // Keeps the latency constant while the oversampler isn't needed
+        activeOversampler.processBypassed(buffer.getArrayOfWritePointers(), numChannels, start, chunkSize);
     }
 }
 
+template <SimpleGainProcessor::KernelType type, typename SampleType>
+void SimpleGainProcessor::processKernel(juce::AudioBuffer<SampleType>& buffer, SampleType* const* envelopes,
+                                        int startSample, int numSamples, int numChannels)
+{
+    // The frequency ramp keeps moving even while the LFO is unused
+    if constexpr (type != KernelType::modulated && type != KernelType::stereo)
+        modFreqSmoother.skip(numSamples);
+
+    auto* channels = buffer.getArrayOfWritePointers();
+    auto* envelope = envelopes[0];
+    auto& gainKernels = kernels.get<SampleType>();
+
+    if constexpr (type == KernelType::passthrough)
+    {
+        juce::ignoreUnused(envelope);
+
+        if (isMeteringBlock)
+        {
+            GainKernels::LevelAccumulator levels;
+            gainKernels.measureLevels(channels, numChannels, startSample, numSamples, levels);
+            GainKernels::mergeLevels(blockInputLevels, levels);
+            GainKernels::mergeLevels(blockOutputLevels, levels);
+        }
+
+        lastEnvelopeGain = 1.0f;
+    }
+    else if constexpr (type == KernelType::staticGain)
+    {
+        const auto gain = gainSmoother.getTargetValue();
+        const auto* stage = outputStage.isActive() ? &outputStage : nullptr;
+        GainKernels::LevelAccumulator levels;
+
+        // Without clipping, the output levels follow directly from the input levels
+        gainKernels.applyGain(channels, numChannels, startSample, (SampleType) gain, numSamples,
+                              isMeteringBlock ? &levels : nullptr,
+                              isMeteringBlock && stage != nullptr ? &blockOutputLevels : nullptr, stage);
+
+        if (isMeteringBlock)
+        {
+            GainKernels::mergeLevels(blockInputLevels, levels);
+
+            if (stage == nullptr)
+                GainKernels::mergeLevels(blockOutputLevels, levels, gain);
+        }
+
+        lastEnvelopeGain = gain;
+    }
+    else if constexpr (type == KernelType::stereo)
+    {
+        renderStereoEnvelopes(envelopes, numSamples, 1);
+
+        // Both envelopes and the M/S matrix go through the channel pair in one pass
+        gainKernels.applyStereoEnvelopes(channels, startSample, envelopes[0], envelopes[1], numSamples, midSideMode,
+                                         isMeteringBlock ? &blockInputLevels : nullptr,
+                                         isMeteringBlock ? &blockOutputLevels : nullptr,
+                                         outputStage.isActive() ? &outputStage : nullptr);
+
+        juce::ignoreUnused(numChannels);
+        lastEnvelopeGain = numSamples > 0 ? (float) envelope[numSamples - 1] : lastEnvelopeGain;
+    }
+    else
+    {
+        if constexpr (type == KernelType::rampingGain)
+        {
+            for (int sample = 0; sample < numSamples; ++sample)
+                envelope[sample] = (SampleType) gainSmoother.getNextValue();
+        }
+        else
+        {
+            renderModulationEnvelope(envelope, numSamples, 1);
+        }
+
+        // Apply the shared envelope to every channel, tile by tile
+        gainKernels.applyEnvelope(channels, numChannels, startSample, envelope, numSamples,
+                                  isMeteringBlock ? &blockInputLevels : nullptr,
+                                  isMeteringBlock ? &blockOutputLevels : nullptr,
+                                  outputStage.isActive() ? &outputStage : nullptr);
+
+        lastEnvelopeGain = numSamples > 0 ? (float) envelope[numSamples - 1] : lastEnvelopeGain;
+    }
+}
+
+template <typename SampleType>
+void SimpleGainProcessor::processOversampledKernel(SampleType* const* channels, SampleType* const* envelopes,
+                                                   int startSample, int numSamples, int numChannels, bool isStereo)
+{
+    auto& activeOversampler = getOversampler<SampleType>();
+    const auto factor = activeOversampler.getFactor();
+    const auto numOversampled = numSamples * factor;
+    auto& gainKernels = kernels.get<SampleType>();
+
+    if (isMeteringBlock)
+        gainKernels.measureLevels(channels, numChannels, startSample, numSamples, blockInputLevels);
+
+    auto upsampled = activeOversampler.processSamplesUp(channels, numChannels, startSample, numSamples);
+
+    // The LFO runs at the oversampled rate, the smoothed parameters at the host rate
+    modulator.setOversamplingFactor(factor);
+    auto* envelope = envelopes[0];
+
+    SampleType* upsampledChannels[maxNumChannels];
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        upsampledChannels[channel] = upsampled.getChannelPointer((size_t) channel);
+
+    // Clipping at the oversampled rate keeps its harmonics from aliasing too
+    const auto* stage = outputStage.isActive() ? &outputStage : nullptr;
+
+    if (isStereo)
+    {
+        renderStereoEnvelopes(envelopes, numOversampled, factor);
+        gainKernels.applyStereoEnvelopes(upsampledChannels, 0, envelopes[0], envelopes[1], numOversampled, midSideMode,
+                                         nullptr, nullptr, stage);
+    }
+    else
+    {
+        renderModulationEnvelope(envelope, numOversampled, factor);
+        gainKernels.applyEnvelope(upsampledChannels, numChannels, 0, envelope, numOversampled, nullptr, nullptr, stage);
+    }
+
+    activeOversampler.processSamplesDown(channels, numChannels, startSample, numSamples);
+
+    // The downsampling filter rings on clipped material, so hold the ceiling again at the host rate
+    if (stage != nullptr)
+    {
+        const GainKernels::OutputStage ceilingStage { GainKernels::OutputStage::Mode::hardClip, stage->ceiling };
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            GainKernels::applyOutputStage(channels[channel] + startSample, numSamples, ceilingStage);
+    }
+
+    if (isMeteringBlock)
+        gainKernels.measureLevels(channels, numChannels, startSample, numSamples, blockOutputLevels);
+
+    lastEnvelopeGain = numOversampled > 0 ? (float) envelope[numOversampled - 1] : lastEnvelopeGain;
+}
+
+template <typename SampleType>
+void SimpleGainProcessor::skipSilentSamples(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples,
+                                            int numChannels, bool isModulated) noexcept
+{
+    // Near-silence becomes true silence, which also keeps denormals out of the host
+    for (int channel = 0; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::clear(buffer.getWritePointer(channel, startSample), numSamples);
+
+    const auto startFrequency = modFreqSmoother.getCurrentValue();
+
+    gainSmoother.skip(numSamples);
+    modDepthSmoother.skip(numSamples);
+    modFreqSmoother.skip(numSamples);
+    skipStereoSmoothers(numSamples);
+
+    // Move the LFO on by the phase it would have covered, using the mean rate over
+    // any frequency ramp, so it carries on without a jump when the input returns
+    if (isModulated)
+    {
+        const auto endFrequency = modFreqSmoother.getCurrentValue();
+
+        modulator.setOversamplingFactor(1);
+        modulator.setFrequency(0.5f * (startFrequency + endFrequency));
+        modulator.advance(numSamples);
+        modulator.setFrequency(endFrequency);
+        modulator.setPhaseOffset(stereoPhaseSmoother.getCurrentValue());
+    }
+
+    if (isMeteringBlock)
+    {
+        blockInputLevels.numSamples += (juce::int64) numSamples * numChannels;
+        blockOutputLevels.numSamples += (juce::int64) numSamples * numChannels;
+    }
+}
+
+template <typename SampleType>
+void SimpleGainProcessor::renderModulationEnvelope(SampleType* envelope, int numSamples, int samplesPerStep) noexcept
+{
+    // Render the LFO once, so all channels share the same phase
+    if (modFreqSmoother.isSmoothing())
+    {
+        for (int step = 0; step < numSamples; step += samplesPerStep)
+        {
+            modulator.setFrequency(modFreqSmoother.getNextValue());
+
+            for (int sample = step; sample < step + samplesPerStep; ++sample)
+                envelope[sample] = (SampleType) modulator.getNextSample();
+        }
+    }
+    else
+    {
+        modulator.process(envelope, numSamples);
+    }
+
+    // Turn it into gain * (1 + depth * LFO)
+    if (gainSmoother.isSmoothing() || modDepthSmoother.isSmoothing())
+    {
+        for (int step = 0; step < numSamples; step += samplesPerStep)
+        {
+            const auto depth = (SampleType) modDepthSmoother.getNextValue();
+            const auto gain = (SampleType) gainSmoother.getNextValue();
+
+            for (int sample = step; sample < step + samplesPerStep; ++sample)
+                envelope[sample] = gain * ((SampleType) 1 + depth * envelope[sample]);
+        }
+    }
+    else
+    {
+        const auto gain = (SampleType) gainSmoother.getTargetValue();
+        juce::FloatVectorOperations::multiply(envelope, gain * (SampleType) modDepthSmoother.getTargetValue(), numSamples);
+        juce::FloatVectorOperations::add(envelope, gain, numSamples);
+    }
+}
+
+template <typename SampleType>
+void SimpleGainProcessor::renderStereoEnvelopes(SampleType* const* envelopes, int numSamples, int samplesPerStep) noexcept
+{
+    auto* first = envelopes[0];
+    auto* second = envelopes[1];
+    const auto numSteps = numSamples / samplesPerStep;
+
+    if (modDepthSmoother.isSmoothing() || modDepthSmoother.getTargetValue() > 0.0f)
+    {
+        // One phase accumulator drives both outputs, so they stay locked together
+        if (modFreqSmoother.isSmoothing() || stereoPhaseSmoother.isSmoothing())
+        {
+            const auto runLength = stereoLfoRunLength * samplesPerStep;
+
+            for (int start = 0; start < numSamples; start += runLength)
+            {
+                const auto length = juce::jmin(runLength, numSamples - start);
+
+                modulator.setFrequency(modFreqSmoother.skip(length / samplesPerStep));
+                modulator.setPhaseOffset(stereoPhaseSmoother.skip(length / samplesPerStep));
+                modulator.process(first + start, second + start, length);
+            }
+        }
+        else
+        {
+            modulator.setPhaseOffset(stereoPhaseSmoother.getTargetValue());
+            modulator.process(first, second, numSamples);
+        }
+
+        // Turn both into gain * (1 + depth * LFO)
+        if (gainSmoother.isSmoothing() || modDepthSmoother.isSmoothing())
+        {
+            for (int step = 0; step < numSamples; step += samplesPerStep)
+            {
+                const auto depth = (SampleType) modDepthSmoother.getNextValue();
+                const auto gain = (SampleType) gainSmoother.getNextValue();
+
+                for (int sample = step; sample < step + samplesPerStep; ++sample)
+                {
+                    first[sample] = gain * ((SampleType) 1 + depth * first[sample]);
+                    second[sample] = gain * ((SampleType) 1 + depth * second[sample]);
+                }
+            }
+        }
+        else
+        {
+            const auto gain = (SampleType) gainSmoother.getTargetValue();
+            const auto scale = gain * (SampleType) modDepthSmoother.getTargetValue();
+
+            for (auto* envelope : { first, second })
+            {
+                juce::FloatVectorOperations::multiply(envelope, scale, numSamples);
+                juce::FloatVectorOperations::add(envelope, gain, numSamples);
+            }
+        }
+    }
+    else
+    {
+        // Only reached in M/S mode: the gain alone, shaped per channel below
+        modFreqSmoother.skip(numSteps);
+        stereoPhaseSmoother.skip(numSteps);
+
+        for (int step = 0; step < numSamples; step += samplesPerStep)
+        {
+            const auto gain = (SampleType) gainSmoother.getNextValue();
+
+            for (int sample = step; sample < step + samplesPerStep; ++sample)
+                first[sample] = second[sample] = gain;
+        }
+    }
+
+    if (! midSideMode)
+    {
+        midGainSmoother.skip(numSteps);
+        sideGainSmoother.skip(numSteps);
+        return;
+    }
+
+    // The mid and side gains scale the two envelopes before they are mixed back to L/R
+    if (midGainSmoother.isSmoothing() || sideGainSmoother.isSmoothing())
+    {
+        for (int step = 0; step < numSamples; step += samplesPerStep)
+        {
+            const auto midGain = (SampleType) midGainSmoother.getNextValue();
+            const auto sideGain = (SampleType) sideGainSmoother.getNextValue();
+
+            for (int sample = step; sample < step + samplesPerStep; ++sample)
+            {
+                first[sample] *= midGain;
+                second[sample] *= sideGain;
+            }
+        }
+    }
+    else
+    {
+        juce::FloatVectorOperations::multiply(first, (SampleType) midGainSmoother.getTargetValue(), numSamples);
+        juce::FloatVectorOperations::multiply(second, (SampleType) sideGainSmoother.getTargetValue(), numSamples);
+    }
+}
+
+float SimpleGainProcessor::getPeakEnvelopeGain(bool isModulated, int numChannels) const noexcept
+{
+    auto largest = [](const juce::SmoothedValue<float>& smoother)
+    {
+        return juce::jmax(std::abs(smoother.getCurrentValue()), std::abs(smoother.getTargetValue()));
+    };
+
+    auto peakGain = largest(gainSmoother);
+
+    if (isModulated)
+        peakGain *= 1.0f + largest(modDepthSmoother);
+
+    // Decoding adds the scaled mid and side, each at most as large as the louder input channel
+    if (numChannels == 2 && midSideMode)
+        peakGain *= largest(midGainSmoother) + largest(sideGainSmoother);
+
+    return peakGain;
+}
+
+bool SimpleGainProcessor::needsStereoProcessing(bool isModulated) const noexcept
+{
+    // With no phase offset the lagging LFO output is the main one, and at unity the
+    // M/S round trip is the identity, so the shared envelope gives the same result
+    const auto hasPhaseOffset = isModulated && (stereoPhaseSmoother.isSmoothing() || stereoPhaseSmoother.getTargetValue() > 0.0f);
+
+    if (! midSideMode)
+        return hasPhaseOffset;
+
+    return hasPhaseOffset
+        || midGainSmoother.isSmoothing() || midGainSmoother.getTargetValue() != 1.0f
+        || sideGainSmoother.isSmoothing() || sideGainSmoother.getTargetValue() != 1.0f;
+}
+
+void SimpleGainProcessor::skipStereoSmoothers(int numSamples) noexcept
+{
+    stereoPhaseSmoother.skip(numSamples);
+    midGainSmoother.skip(numSamples);
+    sideGainSmoother.skip(numSamples);
+}
+
 //==============================================================================
 bool SimpleGainProcessor::hasEditor() const
 {
@@ -217,21 +1257,65 @@ juce::AudioProcessorEditor* SimpleGainProcessor::createEditor()
 //==============================================================================
 void SimpleGainProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    // Plain parameter values in the compact binary format; see BinaryState.h
+    std::array<float, numParameters> values;
+
+    // A program switched on another thread is already playing, so save it rather than the parameters it hasn't reached yet
+    if (programUpdatePending)
+    {
+        auto* programValues = presetBank->getValues(currentProgram);
+        std::copy(programValues, programValues + numParameters, values.begin());
+    }
+    else
+    {
+        for (size_t i = 0; i < values.size(); ++i)
+            values[i] = stateParameters[i]->convertFrom0to1(stateParameters[i]->getValue());
+    }
+
+    destData.setSize(BinaryState::getSize(numParameters));
+    BinaryState::write(destData.getData(), values.data(), numParameters);
 }
 
 void SimpleGainProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    // A restored state wins over a program switch that hasn't reached the parameters yet
+    programUpdatePending = false;
+
+    std::array<float, numParameters> values;
+    const auto numValues = BinaryState::read(data, sizeInBytes, values.data(), numParameters);
+
+    if (numValues >= 0)
+    {
+        // Anything missing or unreadable goes back to its default, as with a replaced XML state
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            auto* parameter = stateParameters[i];
+            const auto hasValue = (int) i < numValues && ! std::isnan(values[i]);
+            const auto newValue = hasValue ? parameter->convertTo0to1(values[i]) : parameter->getDefaultValue();
+
+            // Sessions mostly reload values an instance already has, so skip the listener round trip
+            if (parameter->getValue() != newValue)
+                parameter->setValueNotifyingHost(newValue);
+        }
+
+        return;
+    }
+
+    // States saved before the binary format were the value tree as XML
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     
     if (xmlState.get() != nullptr)
+    {
         if (xmlState->hasTagName(parameters.state.getType()))
+        {
+            // Those stored the rate in Hz under its old ID, which the new range still covers
+            for (auto* child : xmlState->getChildIterator())
+                if (child->getStringAttribute("id") == legacyModFreqID)
+                    child->setAttribute("id", modFreqID);
+
             parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
+        }
+    }
 }
 
 //==============================================================================
@@ -2,6 +2,15 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include "BinaryState.h"
+#include "GainKernels.h"
+#include "KernelDispatch.h"
+#include "ModulationLfo.h"
+#include "ModulationOversampler.h"
+#include "ParameterEventQueue.h"
+#include "PerformanceMonitor.h"
+#include "PresetBank.h"
+#include "TruePeakMeter.h"
 
 //==============================================================================
 /**
@@ -9,7 +18,8 @@
  * It applies a simple gain scaling to the audio signal.
  */
 class SimpleGainProcessor : public juce::AudioProcessor,
-                           public juce::AudioProcessorValueTreeState::Listener
+                           public juce::AudioProcessorValueTreeState::Listener,
+                           private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -23,8 +33,16 @@ public:
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
     using AudioProcessor::processBlock;
 
+    // Passes the input through, delayed by the reported latency
+    void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    using AudioProcessor::processBlockBypassed;
+
+    bool supportsDoublePrecisionProcessing() const override;
+
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -53,23 +71,246 @@ public:
 
     juce::AudioProcessorValueTreeState& getParameters() { return parameters; }
 
+    // Block timing collected on the audio thread
+    PerformanceMonitor& getPerformanceMonitor() { return performanceMonitor; }
+
+    // Linear levels gathered on the audio thread since the previous call
+    struct MeterReadings
+    {
+        float inputPeak = 0.0f;
+        float inputRms = 0.0f;
+        float outputPeak = 0.0f;
+        float outputRms = 0.0f;
+        float outputTruePeak = 0.0f;    // only measured while true-peak metering is on
+        float modulationGain = 1.0f;
+        bool hasNewData = false;
+    };
+
+    MeterReadings consumeMeterReadings() noexcept;
+
+    // Metering is only computed while someone is looking at it
+    void setMeteringEnabled(bool shouldMeter) noexcept;
+
     // Parameter IDs
     static const juce::String gainID;
     static const juce::String modFreqID;
     static const juce::String modDepthID;
+    static const juce::String modShapeID;
+    static const juce::String oversamplingID;
+    static const juce::String clipModeID;
+    static const juce::String ceilingID;
+    static const juce::String truePeakID;
+    static const juce::String stereoModeID;
+    static const juce::String stereoPhaseID;
+    static const juce::String midGainID;
+    static const juce::String sideGainID;
+
+    // Widest bus accepted on input and output (e.g. 7.1.4, higher-order ambisonics)
+    static constexpr int maxNumChannels = 64;
+    static_assert(TruePeakMeter::maxChannels >= maxNumChannels, "True-peak meter must cover every channel");
 
 private:
+    // Kernel variants, chosen per block from the smoothing/modulation state
+    enum class KernelType
+    {
+        passthrough,    // unity gain, no modulation
+        staticGain,     // constant gain, no modulation
+        rampingGain,    // gain ramp, no modulation
+        modulated,      // full gain * (1 + depth * LFO) envelope
+        stereo          // separate left/right or mid/side envelopes, stereo buses only
+    };
+
+    // Parameter indices used in ParameterEvent
+    enum ParameterIndex
+    {
+        gainIndex,
+        modFreqIndex,
+        modDepthIndex,
+        modShapeIndex,
+        oversamplingIndex,
+        clipModeIndex,
+        ceilingIndex,
+        truePeakIndex,
+        stereoModeIndex,
+        stereoPhaseIndex,
+        midGainIndex,
+        sideGainIndex,
+        numParameters,
+
+        // Not a parameter: the value is a program number in the preset bank
+        programIndex = numParameters
+    };
+
+    static_assert(PresetBank::numValues == numParameters, "Preset snapshots must cover every parameter");
+
+    // Audio-thread side of parameter delivery
+    void applyQueuedParameterEvents() noexcept;
+    void applyParameterEvent(const ParameterEvent& event) noexcept;
+    void syncParametersFromAtomics() noexcept;
+    void updateLfoControlRate() noexcept;
+    void publishMeterReadings() noexcept;
+    void applyProgram(int index) noexcept;
+
+    // Plain parameter value to the form ParameterEvent carries (linear gains, phase in cycles)
+    static float toEventValue(int parameterIndex, float plainValue) noexcept;
+
+    // The largest factor the envelope can apply to an input sample over the current ramps
+    float getPeakEnvelopeGain(bool isModulated, int numChannels) const noexcept;
+
+    // True when the two channels of a stereo bus need different envelopes or the M/S matrix
+    bool needsStereoProcessing(bool isModulated) const noexcept;
+    void skipStereoSmoothers(int numSamples) noexcept;
+
+    // Brings the parameter objects in line with the current program
+    void updateParametersFromProgram();
+
+    // Reports the oversampling latency now when called on the message thread, otherwise from handleAsyncUpdate
+    void updateLatency() noexcept;
+
+    // Picks up work deferred from the audio thread, which mustn't call into the host
+    void handleAsyncUpdate() override;
+
+    template <typename SampleType>
+    ModulationOversampler<SampleType>& getOversampler() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleOversampler;
+        else
+            return oversampler;
+    }
+
+    // Shared by both precisions
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, juce::AudioBuffer<SampleType>& envelopeScratch);
+
+    template <typename SampleType>
+    void processBypassedSamples(juce::AudioBuffer<SampleType>& buffer, const juce::AudioBuffer<SampleType>& envelopeScratch);
+
+    // Processes a stretch of the block, in chunks that fit the envelope buffers
+    template <typename SampleType>
+    void processSegment(juce::AudioBuffer<SampleType>& buffer, SampleType* const* envelopes, int maxChunk,
+                        int startSample, int numSamples, int numChannels);
+
+    template <KernelType type, typename SampleType>
+    void processKernel(juce::AudioBuffer<SampleType>& buffer, SampleType* const* envelopes,
+                       int startSample, int numSamples, int numChannels);
+
+    // Modulated kernel at the oversampled rate, shared or stereo
+    template <typename SampleType>
+    void processOversampledKernel(SampleType* const* channels, SampleType* const* envelopes,
+                                  int startSample, int numSamples, int numChannels, bool isStereo);
+
+    // Silent input with nothing left to ring out: clears the output and moves the
+    // ramps and the LFO on as if the samples had been processed
+    template <typename SampleType>
+    void skipSilentSamples(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples,
+                           int numChannels, bool isModulated) noexcept;
+
+    // Writes gain * (1 + depth * LFO), stepping the smoothers once every samplesPerStep values
+    template <typename SampleType>
+    void renderModulationEnvelope(SampleType* envelope, int numSamples, int samplesPerStep) noexcept;
+
+    // Writes the left/right or mid/side envelope pair: the main and lagging LFO outputs
+    // (or just the gain ramp when unmodulated), then the mid/side gains in M/S mode
+    template <typename SampleType>
+    void renderStereoEnvelopes(SampleType* const* envelopes, int numSamples, int samplesPerStep) noexcept;
+
     // Value Tree State for managing parameters
     juce::AudioProcessorValueTreeState parameters;
+
+    // Parameters in ParameterIndex order, as stored in the binary state
+    std::array<juce::RangedAudioParameter*, numParameters> stateParameters {};
+
+    // Programs, shared read-only by every instance
+    juce::SharedResourcePointer<PresetBank> presetBank;
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<bool> programUpdatePending { false };    // switched off the message thread, parameters not caught up yet
+    bool isApplyingProgram { false };                    // message thread only
     
-    // Current parameter values
+    // Latest parameter values, used when preparing and to resynchronise after a queue overflow
     std::atomic<float> currentGain { 1.0f };
     std::atomic<float> currentModFreq { 1.0f };
     std::atomic<float> currentModDepth { 0.0f };
+    std::atomic<int> currentModShape { 0 };
+    std::atomic<int> currentOversampling { 0 };
+    std::atomic<int> currentClipMode { 0 };
+    std::atomic<float> currentCeiling { 1.0f };
+    std::atomic<bool> currentTruePeak { false };
+    std::atomic<int> currentStereoMode { 0 };
+    std::atomic<float> currentStereoPhase { 0.0f };     // cycles
+    std::atomic<float> currentMidGain { 1.0f };
+    std::atomic<float> currentSideGain { 1.0f };
+
+    // Parameter changes, applied at the start of the block they arrive before
+    ParameterEventQueue parameterEvents;
+    std::array<ParameterEvent, ParameterEventQueue::capacity> blockEvents;
     
+    // Audio-thread instrumentation
+    PerformanceMonitor performanceMonitor;
+
     // DSP objects
-    juce::dsp::Oscillator<float> modulator;
+    ModulationLfo modulator;
     double currentSampleRate { 44100.0 };
+
+    // Oversampling for audio-rate modulation; only the one matching the processing precision is prepared
+    ModulationOversampler<float> oversampler;
+    ModulationOversampler<double> doubleOversampler;
+    std::array<std::atomic<int>, ModulationOversampler<float>::numChoices> oversamplingLatencies {};
+    std::atomic<bool> latencyChangePending { false };
+
+    // Per-sample ramps towards the latest parameter values
+    juce::SmoothedValue<float> gainSmoother;
+    juce::SmoothedValue<float> modDepthSmoother;
+    juce::SmoothedValue<float> modFreqSmoother;
+    juce::SmoothedValue<float> stereoPhaseSmoother;
+    juce::SmoothedValue<float> midGainSmoother;
+    juce::SmoothedValue<float> sideGainSmoother;
+
+    // Stereo buses only: encode to mid/side, modulate, decode
+    bool midSideMode { false };
+
+    // The gain kernels built for this CPU's widest supported instruction set
+    const KernelDispatch::KernelTable& kernels { KernelDispatch::getKernels() };
+
+    // Soft clipper / ceiling after the gain, and true-peak metering of the result
+    GainKernels::OutputStage outputStage;
+    bool truePeakEnabled { false };
+    TruePeakMeter truePeakMeter;
+    float blockTruePeak { 0.0f };
+
+    // Consecutive input samples below the silence threshold
+    juce::int64 silentInputSamples { 0 };
+
+    // Levels over the blocks since the editor last took a reading
+    struct MeterWindow
+    {
+        float inputPeak = 0.0f;
+        float outputPeak = 0.0f;
+        float outputTruePeak = 0.0f;
+        double inputSumSquares = 0.0;
+        double outputSumSquares = 0.0;
+        juce::int64 numSamples = 0;
+    };
+
+    // Metering: accumulated per block on the audio thread, then handed to the editor a
+    // whole window at a time. meterWindowReady says which side owns publishedMeterWindow:
+    // the audio thread fills it while it is false, the editor reads it while it is true.
+    std::atomic<bool> meteringEnabled { false };
+    bool isMeteringBlock { false };
+    GainKernels::LevelAccumulator blockInputLevels;
+    GainKernels::LevelAccumulator blockOutputLevels;
+    float lastEnvelopeGain { 1.0f };
+
+    MeterWindow pendingMeterWindow;     // audio thread only
+    MeterWindow publishedMeterWindow;
+    std::atomic<bool> meterWindowReady { false };
+    std::atomic<float> meterModulationGain { 1.0f };
+
+    // Gain x modulation envelope, rendered once per block and shared by all channels; the
+    // second channel holds the other envelope of a stereo pair. Sized for the highest
+    // oversampling factor; only the one matching the processing precision is allocated.
+    juce::AudioBuffer<float> envelopeBuffer;
+    juce::AudioBuffer<double> doubleEnvelopeBuffer;
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SimpleGainProcessor)
@@ -0,0 +1,157 @@
+#include "PresetBank.h"
+#include "BinaryState.h"
+
+//==============================================================================
+namespace
+{
+    constexpr juce::uint32 bankMagic = 0x6b624753;     // "SGbk" when read as little-endian bytes
+    constexpr juce::uint16 bankVersion = 1;
+    constexpr size_t bankHeaderSize = 8;
+
+    // Bounds-checked reads from the mapped file
+    struct BankReader
+    {
+        const char* data;
+        size_t size;
+        size_t position = 0;
+
+        bool canRead(size_t numBytes) const noexcept   { return numBytes <= size - position; }
+
+        const char* take(size_t numBytes) noexcept
+        {
+            auto* start = data + position;
+            position += numBytes;
+            return start;
+        }
+    };
+}
+
+//==============================================================================
+PresetBank::PresetBank()
+    : PresetBank(getDefaultFile())
+{
+}
+
+PresetBank::PresetBank(const juce::File& bankFile)
+{
+    if (! loadFromFile(bankFile))
+        presets = getBuiltInPresets();
+}
+
+juce::File PresetBank::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("SimpleGain")
+               .getChildFile("Presets.sgbank");
+}
+
+std::vector<PresetBank::Preset> PresetBank::getBuiltInPresets()
+{
+    // The first preset holds the parameter defaults, and fills in values a bank file leaves out
+    return {
+        { "Init",           { 0.0f,    1.0f, 0.0f,  0.0f, 0.0f,  0.0f,  0.0f, 0.0f,  0.0f,   0.0f,  0.0f, 0.0f } },
+        { "Pad -6 dB",      { -6.0f,   1.0f, 0.0f,  0.0f, 0.0f,  0.0f,  0.0f, 0.0f,  0.0f,   0.0f,  0.0f, 0.0f } },
+        { "Slow Tremolo",   { 0.0f,    2.0f, 0.5f,  0.0f, 0.0f,  0.0f,  0.0f, 0.0f,  0.0f,   0.0f,  0.0f, 0.0f } },
+        { "Fast Tremolo",   { 0.0f,    8.0f, 0.8f,  1.0f, 0.0f,  0.0f,  0.0f, 0.0f,  0.0f,   0.0f,  0.0f, 0.0f } },
+        { "Chopper",        { 0.0f,    6.0f, 1.0f,  3.0f, 0.0f,  0.0f,  0.0f, 0.0f,  0.0f,   0.0f,  0.0f, 0.0f } },
+        { "Random Steps",   { 0.0f,    4.0f, 0.6f,  4.0f, 0.0f,  0.0f,  0.0f, 0.0f,  0.0f,   0.0f,  0.0f, 0.0f } },
+        { "Ring Mod",       { -3.0f, 440.0f, 1.0f,  0.0f, 2.0f,  0.0f,  0.0f, 0.0f,  0.0f,   0.0f,  0.0f, 0.0f } },
+        { "Drive",          { 12.0f,   1.0f, 0.0f,  0.0f, 0.0f,  1.0f, -1.0f, 1.0f,  0.0f,   0.0f,  0.0f, 0.0f } },
+        { "Auto-Pan",       { 0.0f,    0.5f, 1.0f,  0.0f, 0.0f,  0.0f,  0.0f, 0.0f,  0.0f, 180.0f,  0.0f, 0.0f } },
+        { "Wide",           { 0.0f,    1.0f, 0.0f,  0.0f, 0.0f,  0.0f,  0.0f, 0.0f,  1.0f,   0.0f, -1.5f, 4.0f } },
+        { "Side Swirl",     { 0.0f,    3.0f, 0.7f,  1.0f, 0.0f,  0.0f,  0.0f, 0.0f,  1.0f,  90.0f,  0.0f, 0.0f } }
+    };
+}
+
+//==============================================================================
+bool PresetBank::loadFromFile(const juce::File& bankFile)
+{
+    if (! bankFile.existsAsFile())
+        return false;
+
+    // Mapped only for as long as it takes to decode the snapshots
+    juce::MemoryMappedFile mappedFile(bankFile, juce::MemoryMappedFile::readOnly);
+
+    if (mappedFile.getData() == nullptr)
+        return false;
+
+    BankReader reader { static_cast<const char*>(mappedFile.getData()), mappedFile.getSize() };
+
+    if (! reader.canRead(bankHeaderSize) || juce::ByteOrder::littleEndianInt(reader.data) != bankMagic)
+        return false;
+
+    auto* header = reader.take(bankHeaderSize);
+    const auto numPresets = (int) juce::ByteOrder::littleEndianShort(header + 6);
+
+    if (juce::ByteOrder::littleEndianShort(header + 4) == 0 || numPresets == 0)
+        return false;
+
+    const auto defaults = getBuiltInPresets().front().values;
+    std::vector<Preset> loaded;
+    loaded.reserve((size_t) numPresets);
+
+    for (int i = 0; i < numPresets; ++i)
+    {
+        if (! reader.canRead(1))
+            return false;
+
+        const auto nameLength = (size_t) (juce::uint8) *reader.take(1);
+
+        if (! reader.canRead(nameLength + 4))
+            return false;
+
+        Preset preset { juce::String::fromUTF8(reader.take(nameLength), (int) nameLength), defaults };
+        const auto stateSize = (size_t) juce::ByteOrder::littleEndianInt(reader.take(4));
+
+        if (! reader.canRead(stateSize))
+            return false;
+
+        std::array<float, numValues> values;
+        const auto numRead = BinaryState::read(reader.take(stateSize), (int) stateSize, values.data(), numValues);
+
+        if (numRead < 0)
+            return false;
+
+        for (int v = 0; v < numRead; ++v)
+            if (! std::isnan(values[(size_t) v]))
+                preset.values[(size_t) v] = values[(size_t) v];
+
+        loaded.push_back(std::move(preset));
+    }
+
+    presets = std::move(loaded);
+    loadedFromFile = true;
+    return true;
+}
+
+bool PresetBank::writeToFile(const juce::File& bankFile, const std::vector<Preset>& presetsToWrite)
+{
+    if (presetsToWrite.empty() || presetsToWrite.size() > 0xffff)
+        return false;
+
+    juce::MemoryOutputStream stream;
+    stream.writeInt((int) bankMagic);
+    stream.writeShort((short) bankVersion);
+    stream.writeShort((short) presetsToWrite.size());
+
+    char state[BinaryState::getSize(numValues)];
+
+    for (auto& preset : presetsToWrite)
+    {
+        // Names longer than a length byte allows are cut at a character boundary
+        auto name = preset.name;
+
+        while (name.getNumBytesAsUTF8() > 255)
+            name = name.dropLastCharacters(1);
+
+        stream.writeByte((char) name.getNumBytesAsUTF8());
+        stream.write(name.toRawUTF8(), name.getNumBytesAsUTF8());
+
+        BinaryState::write(state, preset.values.data(), numValues);
+        stream.writeInt((int) sizeof(state));
+        stream.write(state, sizeof(state));
+    }
+
+    return bankFile.getParentDirectory().createDirectory()
+        && bankFile.replaceWithData(stream.getData(), stream.getDataSize());
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <vector>
+
+//==============================================================================
+/**
+ * PresetBank holds the plugin's programs as flat, pre-decoded parameter
+ * snapshots, so switching program never has to parse anything.
+ *
+ * The bank is read once from a memory-mapped file (see getDefaultFile()) and
+ * falls back to a small built-in set when there is no valid file. It never
+ * changes after construction, which lets the audio thread read snapshots
+ * without locking; SimpleGainProcessor shares one bank between all instances.
+ *
+ * A bank file is a header followed by one entry per preset:
+ *
+ *     uint32  magic ('SGbk'), uint16 version, uint16 number of presets
+ *     uint8   name length, then the UTF-8 name
+ *     uint32  state size, then a BinaryState block with the preset's values
+ */
+class PresetBank
+{
+public:
+    // Plain values in SimpleGainProcessor's ParameterIndex order: gain (dB),
+    // mod freq (Hz), mod depth, mod shape, oversampling choice, clip mode,
+    // ceiling (dB), true-peak metering, stereo mode, stereo phase (degrees),
+    // mid gain (dB), side gain (dB)
+    static constexpr int numValues = 12;
+
+    struct Preset
+    {
+        juce::String name;
+        std::array<float, numValues> values;
+    };
+
+    //==============================================================================
+    // Loads getDefaultFile(), or the built-in presets if it can't be read
+    PresetBank();
+    explicit PresetBank(const juce::File& bankFile);
+
+    int getNumPresets() const noexcept                      { return (int) presets.size(); }
+    const juce::String& getName(int index) const noexcept   { return presets[(size_t) clampIndex(index)].name; }
+
+    // Never null; out of range indices are clamped
+    const float* getValues(int index) const noexcept        { return presets[(size_t) clampIndex(index)].values.data(); }
+
+    bool isFromFile() const noexcept                        { return loadedFromFile; }
+
+    //==============================================================================
+    static juce::File getDefaultFile();
+    static std::vector<Preset> getBuiltInPresets();
+
+    static bool writeToFile(const juce::File& bankFile, const std::vector<Preset>& presetsToWrite);
+
+private:
+    //==============================================================================
+    bool loadFromFile(const juce::File& bankFile);
+    int clampIndex(int index) const noexcept                { return juce::jlimit(0, (int) presets.size() - 1, index); }
+
+    std::vector<Preset> presets;
+    bool loadedFromFile = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetBank)
+};
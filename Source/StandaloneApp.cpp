@@ -0,0 +1,253 @@
+#if JucePlugin_Build_Standalone && JUCE_USE_CUSTOM_PLUGIN_STANDALONE_APP
+
+#include "HeadlessEngine.h"
+#include <juce_audio_plugin_client/Standalone/juce_StandaloneFilterWindow.h>
+#include <csignal>
+#include <iostream>
+
+//==============================================================================
+/**
+ * The standalone app. Without arguments it behaves like JUCE's own standalone
+ * wrapper and opens the plugin in a window; with --headless it runs the plugin
+ * on an audio device with no GUI, as an always-on processing node.
+ *
+ * Usage:
+ *   "Simple Gain" --headless [--device-type=ALSA|JACK|Dummy] [--device=<name>]
+ *                 [--input-device=<name>] [--output-device=<name>] [--sample-rate=<hz>]
+ *                 [--buffer-size=<samples>] [--inputs=<n>] [--outputs=<n>]
+ *                 [--rt-priority=<1-99|0>] [--no-mlock] [--state=<file>] [--program=<n>]
+ *                 [--duration=<seconds>] [--report-interval=<seconds>] [--report=<file>]
+ *                 [--max-xruns=<n>]
+ *   "Simple Gain" --list-devices
+ *
+ * A headless run prints a status line every --report-interval seconds (10 by
+ * default, 0 for none) and a summary when it stops, on SIGINT or SIGTERM or
+ * after --duration. --report writes the summary as JSON. The exit code is 1 if
+ * the device failed to start, no callback ever ran, or there were more than
+ * --max-xruns xruns.
+ */
+class SimpleGainStandaloneApp : public juce::JUCEApplication,
+                                private juce::Timer
+{
+public:
+    SimpleGainStandaloneApp()
+    {
+        juce::PropertiesFile::Options propertiesOptions;
+        propertiesOptions.applicationName = juce::CharPointer_UTF8(JucePlugin_Name);
+        propertiesOptions.filenameSuffix = ".settings";
+        propertiesOptions.osxLibrarySubFolder = "Application Support";
+       #if JUCE_LINUX || JUCE_BSD
+        propertiesOptions.folderName = "~/.config";
+       #else
+        propertiesOptions.folderName = "";
+       #endif
+
+        appProperties.setStorageParameters(propertiesOptions);
+    }
+
+    const juce::String getApplicationName() override            { return juce::CharPointer_UTF8(JucePlugin_Name); }
+    const juce::String getApplicationVersion() override         { return JucePlugin_VersionString; }
+    bool moreThanOneInstanceAllowed() override                  { return true; }
+    void anotherInstanceStarted(const juce::String&) override   {}
+
+    //==============================================================================
+    void initialise(const juce::String& commandLine) override
+    {
+        const juce::ArgumentList args(getApplicationName(), commandLine);
+
+        if (args.containsOption("--list-devices"))
+        {
+            std::cout << HeadlessEngine().describeDevices();
+            quit();
+        }
+        else if (args.containsOption("--headless"))
+        {
+            startHeadless(args);
+        }
+        else if (juce::Desktop::getInstance().getDisplays().displays.isEmpty())
+        {
+            // No display to open a window on: run the plugin with its saved device settings
+            pluginHolder = std::make_unique<juce::StandalonePluginHolder>(appProperties.getUserSettings(), false);
+        }
+        else
+        {
+            mainWindow = std::make_unique<juce::StandaloneFilterWindow>(
+                getApplicationName(),
+                juce::LookAndFeel::getDefaultLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId),
+                appProperties.getUserSettings(), false);
+
+            mainWindow->setVisible(true);
+        }
+    }
+
+    void shutdown() override
+    {
+        if (engine != nullptr)
+            stopHeadless();
+
+        pluginHolder = nullptr;
+        mainWindow = nullptr;
+        appProperties.saveIfNeeded();
+    }
+
+    void systemRequestedQuit() override
+    {
+        if (pluginHolder != nullptr)
+            pluginHolder->savePluginState();
+
+        if (mainWindow != nullptr)
+            mainWindow->pluginHolder->savePluginState();
+
+        if (juce::ModalComponentManager::getInstance()->cancelAllModalComponents())
+        {
+            juce::Timer::callAfterDelay(100, []
+            {
+                if (auto* app = juce::JUCEApplicationBase::getInstance())
+                    app->systemRequestedQuit();
+            });
+        }
+        else
+        {
+            quit();
+        }
+    }
+
+private:
+    //==============================================================================
+    static inline std::atomic<bool> stopRequested { false };
+
+    static void requestStop(int)
+    {
+        stopRequested = true;
+    }
+
+    void startHeadless(const juce::ArgumentList& args)
+    {
+        auto intOption = [&args](const juce::String& option, int defaultValue)
+        {
+            return args.containsOption(option) ? args.getValueForOption(option).getIntValue() : defaultValue;
+        };
+
+        auto doubleOption = [&args](const juce::String& option, double defaultValue)
+        {
+            return args.containsOption(option) ? args.getValueForOption(option).getDoubleValue() : defaultValue;
+        };
+
+        HeadlessEngine::Options options;
+        options.deviceType = args.getValueForOption("--device-type");
+        options.outputDevice = args.containsOption("--output-device") ? args.getValueForOption("--output-device")
+                                                                      : args.getValueForOption("--device");
+        options.inputDevice = args.containsOption("--input-device") ? args.getValueForOption("--input-device")
+                                                                    : args.getValueForOption("--device");
+        options.sampleRate = doubleOption("--sample-rate", 0.0);
+        options.bufferSize = intOption("--buffer-size", 0);
+        options.numInputChannels = intOption("--inputs", 2);
+        options.numOutputChannels = intOption("--outputs", 2);
+        options.realtimePriority = juce::jlimit(0, 99, intOption("--rt-priority", options.realtimePriority));
+        options.lockMemory = ! args.containsOption("--no-mlock");
+        options.program = intOption("--program", -1);
+
+        if (args.containsOption("--state"))
+            options.stateFile = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--state"));
+
+        durationSeconds = doubleOption("--duration", 0.0);
+        reportIntervalSeconds = doubleOption("--report-interval", 10.0);
+        maxXRuns = intOption("--max-xruns", -1);
+
+        if (args.containsOption("--report"))
+            reportFile = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--report"));
+
+        auto error = juce::String();
+
+        if (! juce::isPositiveAndNotGreaterThan(options.numInputChannels, SimpleGainProcessor::maxNumChannels))
+            error = "--inputs must be between 0 and " + juce::String(SimpleGainProcessor::maxNumChannels);
+        else if (options.numOutputChannels < 1 || options.numOutputChannels > SimpleGainProcessor::maxNumChannels)
+            error = "--outputs must be between 1 and " + juce::String(SimpleGainProcessor::maxNumChannels);
+
+        if (error.isEmpty())
+        {
+            engine = std::make_unique<HeadlessEngine>();
+            error = engine->start(options);
+        }
+
+        if (error.isNotEmpty())
+        {
+            std::cerr << getApplicationName() << ": " << error << std::endl;
+            engine = nullptr;
+            setApplicationReturnValue(1);
+            quit();
+            return;
+        }
+
+        const auto status = engine->getStatus();
+        std::cout << status.deviceType << " \"" << status.deviceName << "\", " << status.sampleRate << " Hz, "
+                  << status.bufferSize << " samples, " << status.latencySamples << " samples round-trip latency"
+                  << std::endl;
+
+        if (options.bufferSize > 0 && status.bufferSize != options.bufferSize)
+            std::cerr << "Buffer size " << options.bufferSize << " is not available; using " << status.bufferSize << std::endl;
+
+        if (options.lockMemory && ! status.memoryLocked)
+            std::cerr << status.memoryLockError << std::endl;
+
+        std::signal(SIGINT, requestStop);
+        std::signal(SIGTERM, requestStop);
+
+        nextReportSeconds = reportIntervalSeconds;
+        startTimer(250);
+    }
+
+    void stopHeadless()
+    {
+        stopTimer();
+
+        const auto status = engine->getStatus();
+        engine->stop();
+        engine = nullptr;
+
+        std::cout << "Summary: " << status.toString() << std::endl;
+
+        if (status.realtime == HeadlessEngine::RealtimeState::failed)
+            std::cerr << "Could not raise the audio thread to real-time priority (see RLIMIT_RTPRIO)" << std::endl;
+
+        if (reportFile != juce::File() && ! reportFile.replaceWithText(status.toJson() + "\n"))
+            std::cerr << "Could not write " << reportFile.getFullPathName() << std::endl;
+
+        if (status.numCallbacks == 0 || (maxXRuns >= 0 && status.deviceXRuns > maxXRuns))
+            setApplicationReturnValue(1);
+    }
+
+    void timerCallback() override
+    {
+        // Also keeps the timing ring buffers drained between reports
+        const auto status = engine->getStatus();
+
+        if (reportIntervalSeconds > 0.0 && status.runningSeconds >= nextReportSeconds)
+        {
+            std::cout << status.toString() << std::endl;
+            nextReportSeconds += reportIntervalSeconds;
+        }
+
+        if (stopRequested || (durationSeconds > 0.0 && status.runningSeconds >= durationSeconds))
+        {
+            stopTimer();
+            quit();
+        }
+    }
+
+    //==============================================================================
+    juce::ApplicationProperties appProperties;
+    std::unique_ptr<juce::StandaloneFilterWindow> mainWindow;
+    std::unique_ptr<juce::StandalonePluginHolder> pluginHolder;
+
+    std::unique_ptr<HeadlessEngine> engine;
+    double durationSeconds = 0.0;
+    double reportIntervalSeconds = 10.0;
+    double nextReportSeconds = 0.0;
+    int maxXRuns = -1;
+    juce::File reportFile;
+};
+
+JUCE_CREATE_APPLICATION_DEFINE(SimpleGainStandaloneApp)
+
+#endif
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+
+//==============================================================================
+/**
+ * TruePeakMeter estimates the inter-sample peak of a signal by interpolating
+ * it at 4x with the 48-tap polyphase filter from ITU-R BS.1770-4, Annex 2.
+ *
+ * Each channel keeps the last few input samples, so consecutive blocks are
+ * measured without seams. Work is done in short runs, one filter phase at a
+ * time, so the inner loops vectorise. Nothing allocates.
+ */
+class TruePeakMeter
+{
+public:
+    // Enough for SimpleGainProcessor's widest bus
+    static constexpr int maxChannels = 64;
+
+    void reset() noexcept
+    {
+        for (auto& channelHistory : history)
+            channelHistory.fill(0.0f);
+    }
+
+    // Highest interpolated magnitude over numSamples of one channel
+    template <typename SampleType>
+    float process(int channel, const SampleType* data, int numSamples) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(channel, maxChannels));
+
+        auto& past = history[(size_t) channel];
+        float window[numTaps - 1 + runLength];
+        float peak = 0.0f;
+
+        for (int start = 0; start < numSamples; start += runLength)
+        {
+            const auto length = juce::jmin(runLength, numSamples - start);
+
+            std::copy(past.begin(), past.end(), window);
+
+            for (int i = 0; i < length; ++i)
+                window[numTaps - 1 + i] = (float) data[start + i];
+
+            for (auto& phase : coefficients)
+            {
+                float interpolated[runLength] = {};
+
+                for (int tap = 0; tap < numTaps; ++tap)
+                {
+                    const auto coefficient = phase[(size_t) tap];
+
+                    for (int i = 0; i < length; ++i)
+                        interpolated[i] += coefficient * window[i + tap];
+                }
+
+                for (int i = 0; i < length; ++i)
+                {
+                    const auto magnitude = interpolated[i] < 0.0f ? -interpolated[i] : interpolated[i];
+                    peak = magnitude > peak ? magnitude : peak;
+                }
+            }
+
+            std::copy(window + length, window + length + numTaps - 1, past.begin());
+        }
+
+        return peak;
+    }
+
+private:
+    //==============================================================================
+    static constexpr int numTaps = 12;
+    static constexpr int runLength = 64;
+
+    // The four phases are mirror images of each other, so applying the taps in
+    // either time order finds the same peak
+    static constexpr std::array<std::array<float, numTaps>, 4> coefficients {{
+        { 0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f, -0.0594482421875f,  0.1373291015625f,
+          0.9721679687500f, -0.1022949218750f,  0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+        { -0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f, -0.1665039062500f,  0.4650878906250f,
+           0.7797851562500f, -0.2003173828125f,  0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+        { -0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f, -0.2003173828125f,  0.7797851562500f,
+           0.4650878906250f, -0.1665039062500f,  0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+        { -0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f, -0.1022949218750f,  0.9721679687500f,
+           0.1373291015625f, -0.0594482421875f,  0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f }
+    }};
+
+    std::array<std::array<float, numTaps - 1>, maxChannels> history {};
+};
@@ -0,0 +1,117 @@
+#include "TestUtilities.h"
+#include "HeadlessEngine.h"
+
+//==============================================================================
+/**
+ * The dummy audio device and the headless engine that runs the processor on
+ * it. Both run in real time, so each test only lets the device play briefly.
+ */
+class HeadlessTests : public juce::UnitTest
+{
+public:
+    HeadlessTests() : juce::UnitTest("Headless engine", "Headless") {}
+
+    void runTest() override
+    {
+        beginTest("Loopback device feeds each block's outputs back as the next block's inputs");
+        {
+            DummyAudioIODeviceType type;
+            std::unique_ptr<juce::AudioIODevice> device(type.createDevice("Loopback", {}));
+            expect(device != nullptr);
+
+            juce::BigInteger channels;
+            channels.setRange(0, 2, true);
+            expectEquals(device->open(channels, channels, 48000.0, 64), juce::String());
+
+            LoopbackCheck callback;
+            device->start(&callback);
+            juce::Thread::sleep(200);
+            device->stop();
+
+            expect(callback.numBlocks > 2);
+            expectEquals(callback.numMismatches.load(), 0);
+            expectEquals(device->getCurrentBufferSizeSamples(), 64);
+        }
+
+        beginTest("Unknown devices and device types are reported");
+        {
+            DummyAudioIODeviceType type;
+            expect(type.createDevice("No such device", {}) == nullptr);
+
+            HeadlessEngine engine;
+            expect(engine.start(makeOptions("No such type", "Sine")).isNotEmpty());
+            expect(engine.start(makeOptions(DummyAudioIODeviceType::typeName, "No such device")).isNotEmpty());
+            expect(! engine.isRunning());
+        }
+
+        beginTest("Engine runs the processor on the dummy device");
+        {
+            HeadlessEngine engine;
+            expectEquals(engine.start(makeOptions(DummyAudioIODeviceType::typeName, "Sine")), juce::String());
+            expect(engine.isRunning());
+            expect(engine.getProcessor() != nullptr);
+
+            juce::Thread::sleep(300);
+            const auto status = engine.getStatus();
+            engine.stop();
+
+            expectEquals(status.deviceType, juce::String(DummyAudioIODeviceType::typeName));
+            expectEquals(status.deviceName, juce::String("Sine"));
+            expectEquals(status.sampleRate, 48000.0);
+            expectEquals(status.bufferSize, 128);
+            expect(status.numCallbacks > 0);
+            expect(status.callbackTiming.numBlocks > 0);
+            expect(status.deviceXRuns >= 0);
+            expect(status.realtime == HeadlessEngine::RealtimeState::notAttempted);
+            expect(! status.memoryLocked);
+
+            auto json = juce::JSON::parse(status.toJson());
+            expectEquals((int) json["buffer_size"], 128);
+            expect(json["callback"].isObject());
+            expect(! engine.isRunning());
+        }
+    }
+
+private:
+    //==============================================================================
+    // Writes the block count to every output and checks the inputs carry the previous count
+    struct LoopbackCheck : public juce::AudioIODeviceCallback
+    {
+        void audioDeviceIOCallbackWithContext(const float* const* inputs, int numInputs,
+                                              float* const* outputs, int numOutputs,
+                                              int numSamples, const juce::AudioIODeviceCallbackContext&) override
+        {
+            const auto expected = (float) numBlocks.load();
+
+            for (int channel = 0; channel < numInputs; ++channel)
+                if (numBlocks > 0 && (inputs[channel][0] != expected || inputs[channel][numSamples - 1] != expected))
+                    ++numMismatches;
+
+            for (int channel = 0; channel < numOutputs; ++channel)
+                juce::FloatVectorOperations::fill(outputs[channel], expected + 1.0f, numSamples);
+
+            ++numBlocks;
+        }
+
+        void audioDeviceAboutToStart(juce::AudioIODevice*) override {}
+        void audioDeviceStopped() override {}
+
+        std::atomic<int> numBlocks { 0 }, numMismatches { 0 };
+    };
+
+    static HeadlessEngine::Options makeOptions(const juce::String& deviceType, const juce::String& device)
+    {
+        HeadlessEngine::Options options;
+        options.deviceType = deviceType;
+        options.outputDevice = device;
+        options.sampleRate = 48000.0;
+        options.bufferSize = 128;
+
+        // A test shouldn't need RLIMIT_RTPRIO or RLIMIT_MEMLOCK
+        options.realtimePriority = 0;
+        options.lockMemory = false;
+        return options;
+    }
+};
+
+static HeadlessTests headlessTests;
@@ -0,0 +1,507 @@
+#include "GainKernels.h"
+#include "KernelDispatch.h"
+#include "ModulationLfo.h"
+#include "TruePeakMeter.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+ * The GainKernels loops, the LFO and the true-peak meter against plain scalar
+ * versions of the same maths.
+ *
+ * Tolerances: the gain and envelope kernels do the same single multiply per
+ * sample as the scalar loop, so they must match exactly. The mid/side matrix
+ * rounds differently from a separate encode/decode, within a few float ulps
+ * (1e-6 at full scale). The LFO's 2048-point sine table is within 2e-6 of
+ * std::sin, and its control-rate interpolation at 16 samples within 2e-5 for
+ * rates up to 5 Hz at 48 kHz.
+ */
+class GainKernelTests : public juce::UnitTest
+{
+public:
+    GainKernelTests() : juce::UnitTest("Gain kernels", "Kernels") {}
+
+    void runTest() override
+    {
+        // Every specialised bus width plus an odd one, at lengths around the tile size
+        const int channelCounts[] = { 1, 2, 3, 4, 6, 8, 12, 16 };
+        const int lengths[] = { 1, 7, GainKernels::tileSize - 1, GainKernels::tileSize, GainKernels::tileSize + 1, 1000 };
+
+        beginTest("applyGain matches a scalar multiply");
+        {
+            for (auto numChannels : channelCounts)
+                for (auto length : lengths)
+                    expectEquals(gainError<float>(numChannels, length), 0.0, describe(numChannels, length));
+        }
+
+        beginTest("applyEnvelope matches a scalar multiply");
+        {
+            for (auto numChannels : channelCounts)
+                for (auto length : lengths)
+                {
+                    expectEquals(envelopeError<float>(numChannels, length), 0.0, describe(numChannels, length));
+                    expectEquals(envelopeError<double>(numChannels, length), 0.0, describe(numChannels, length));
+                }
+        }
+
+        beginTest("Level metering sees every sample");
+        {
+            juce::AudioBuffer<float> buffer(3, 1000);
+            fill(buffer);
+            buffer.setSample(2, 777, -1.5f);
+
+            GainKernels::LevelAccumulator levels;
+            GainKernels::measureLevels(buffer.getArrayOfWritePointers(), 3, 0, 1000, levels);
+
+            double sumSquares = 0.0;
+
+            for (int channel = 0; channel < 3; ++channel)
+                for (int sample = 0; sample < 1000; ++sample)
+                    sumSquares += (double) buffer.getSample(channel, sample) * buffer.getSample(channel, sample);
+
+            expectEquals(levels.peak, 1.5);
+            expectEquals((int) levels.numSamples, 3000);
+            expectWithinAbsoluteError(levels.sumSquares, sumSquares, sumSquares * 1.0e-4);
+        }
+
+        beginTest("Stereo envelopes match separate encode, modulate and decode");
+        {
+            for (auto length : lengths)
+            {
+                expectEquals(stereoError(length, false), 0.0, "L/R, " + juce::String(length) + " samples");
+                expectLessThan(stereoError(length, true), 1.0e-6, "M/S, " + juce::String(length) + " samples");
+            }
+        }
+
+        beginTest("isSilent finds a single loud sample anywhere");
+        {
+            juce::AudioBuffer<float> buffer(4, 1000);
+            buffer.clear();
+            expect(GainKernels::isSilent(buffer.getArrayOfReadPointers(), 4, 0, 1000, 1.0e-6f));
+
+            for (auto position : { 0, 255, 256, 999 })
+            {
+                buffer.clear();
+                buffer.setSample(3, position, -1.0e-5f);
+                expect(! GainKernels::isSilent(buffer.getArrayOfReadPointers(), 4, 0, 1000, 1.0e-6f));
+            }
+        }
+
+        beginTest("Soft clipper is odd, monotonic and stays inside the ceiling");
+        {
+            auto previous = -2.0f;
+
+            for (int i = -4000; i <= 4000; ++i)
+            {
+                const auto x = (float) i / 500.0f;
+                const auto y = GainKernels::softClip(x);
+
+                expect(y >= previous && std::abs(y) <= 1.0f);
+                expectEquals(GainKernels::softClip(-x), -y);
+                previous = y;
+            }
+
+            expectWithinAbsoluteError(GainKernels::softClip(0.01f), std::tanh(0.01f), 1.0e-6f);
+
+            GainKernels::OutputStage stage { GainKernels::OutputStage::Mode::hardClip, 0.5f };
+            float data[] = { -2.0f, -0.25f, 0.0f, 0.49f, 3.0f };
+            GainKernels::applyOutputStage(data, 5, stage);
+            expectEquals(data[0], -0.5f);
+            expectEquals(data[1], -0.25f);
+            expectEquals(data[4], 0.5f);
+        }
+    }
+
+private:
+    static juce::String describe(int numChannels, int length)
+    {
+        return juce::String(numChannels) + " channels, " + juce::String(length) + " samples";
+    }
+
+    template <typename SampleType>
+    void fill(juce::AudioBuffer<SampleType>& buffer)
+    {
+        auto& random = getRandom();
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+                buffer.setSample(channel, sample, (SampleType) (random.nextFloat() * 2.0f - 1.0f));
+    }
+
+    template <typename SampleType>
+    double gainError(int numChannels, int length)
+    {
+        juce::AudioBuffer<SampleType> buffer(numChannels, length + 3);
+        fill(buffer);
+        juce::AudioBuffer<SampleType> expected(buffer);
+        const auto gain = (SampleType) 0.3;
+
+        // Offset start, so the tiles don't line up with the buffer
+        GainKernels::applyGain(buffer.getArrayOfWritePointers(), numChannels, 3, gain, length);
+
+        double error = 0.0;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int sample = 0; sample < length + 3; ++sample)
+            {
+                const auto reference = sample < 3 ? expected.getSample(channel, sample) : expected.getSample(channel, sample) * gain;
+                error = juce::jmax(error, std::abs((double) (buffer.getSample(channel, sample) - reference)));
+            }
+
+        return error;
+    }
+
+    template <typename SampleType>
+    double envelopeError(int numChannels, int length)
+    {
+        juce::AudioBuffer<SampleType> buffer(numChannels, length);
+        juce::AudioBuffer<SampleType> envelope(1, length);
+        fill(buffer);
+        fill(envelope);
+        juce::AudioBuffer<SampleType> expected(buffer);
+
+        GainKernels::applyEnvelope(buffer.getArrayOfWritePointers(), numChannels, 0, envelope.getReadPointer(0), length);
+
+        double error = 0.0;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int sample = 0; sample < length; ++sample)
+                error = juce::jmax(error, std::abs((double) (buffer.getSample(channel, sample)
+                                                             - expected.getSample(channel, sample) * envelope.getSample(0, sample))));
+
+        return error;
+    }
+
+    double stereoError(int length, bool midSide)
+    {
+        juce::AudioBuffer<float> buffer(2, length);
+        juce::AudioBuffer<float> envelopes(2, length);
+        fill(buffer);
+        fill(envelopes);
+        juce::AudioBuffer<float> expected(buffer);
+
+        GainKernels::applyStereoEnvelopes(buffer.getArrayOfWritePointers(), 0, envelopes.getReadPointer(0),
+                                          envelopes.getReadPointer(1), length, midSide);
+
+        double error = 0.0;
+
+        for (int sample = 0; sample < length; ++sample)
+        {
+            const auto left = expected.getSample(0, sample);
+            const auto right = expected.getSample(1, sample);
+            const auto first = envelopes.getSample(0, sample);
+            const auto second = envelopes.getSample(1, sample);
+            float expectedLeft, expectedRight;
+
+            if (midSide)
+            {
+                const auto mid = 0.5f * (left + right) * first;
+                const auto side = 0.5f * (left - right) * second;
+                expectedLeft = mid + side;
+                expectedRight = mid - side;
+            }
+            else
+            {
+                expectedLeft = left * first;
+                expectedRight = right * second;
+            }
+
+            error = juce::jmax(error, (double) std::abs(buffer.getSample(0, sample) - expectedLeft));
+            error = juce::jmax(error, (double) std::abs(buffer.getSample(1, sample) - expectedRight));
+        }
+
+        return error;
+    }
+};
+
+//==============================================================================
+/**
+ * Every kernel variant this CPU can run, against the baseline build. They do the
+ * same operations in the same order without FMA contraction, so outputs and
+ * levels must be bit-identical, not merely close.
+ */
+class KernelDispatchTests : public juce::UnitTest
+{
+public:
+    KernelDispatchTests() : juce::UnitTest("Kernel dispatch", "Kernels") {}
+
+    void runTest() override
+    {
+        beginTest("The selected variant can run here");
+        {
+            const auto& selected = KernelDispatch::getKernels();
+            expect(KernelDispatch::isSupported(selected.variant));
+            expect(KernelDispatch::getKernels(KernelDispatch::Variant::baseline) != nullptr);
+            logMessage(juce::String("Selected kernels: ") + KernelDispatch::getName(selected.variant));
+        }
+
+        auto* baseline = KernelDispatch::getKernels(KernelDispatch::Variant::baseline);
+
+        for (int i = 1; i < (int) KernelDispatch::Variant::numVariants; ++i)
+        {
+            const auto variant = (KernelDispatch::Variant) i;
+            auto* kernels = KernelDispatch::getKernels(variant);
+
+            if (kernels == nullptr)
+            {
+                logMessage(juce::String("Skipping ") + KernelDispatch::getName(variant) + ", not supported here");
+                continue;
+            }
+
+            beginTest(juce::String(KernelDispatch::getName(variant)) + " matches the baseline bit for bit");
+            {
+                for (auto numChannels : { 1, 2, 3, 6, 16 })
+                    for (auto length : { 1, 13, GainKernels::tileSize + 5, 1000 })
+                    {
+                        compare<float>(*baseline, *kernels, numChannels, length);
+                        compare<double>(*baseline, *kernels, numChannels, length);
+                    }
+            }
+        }
+    }
+
+private:
+    // The channels as independent streams, every other one in the middle of a ramp. With
+    // more than three, the fourth runs at audio rate and takes the per-sample path.
+    template <typename SampleType>
+    static void runStreams(const KernelDispatch::KernelSet<SampleType>& kernels, SampleType* const* channels,
+                           int numChannels, int length)
+    {
+        std::vector<juce::uint32> phases, increments;
+        std::vector<float> gains, gainSteps, gainTargets, depths, depthSteps, depthTargets;
+        std::vector<int> rampRemaining;
+
+        for (int stream = 0; stream < numChannels; ++stream)
+        {
+            const auto ramping = stream % 2 == 1;
+            phases.push_back((juce::uint32) (std::fmod(0.137 * stream, 1.0) * 4294967296.0));
+            increments.push_back((juce::uint32) ((stream == 3 ? 0.05 : 0.001 + 0.0003 * stream) * 4294967296.0));
+            gains.push_back(1.0f + 0.1f * (float) stream);
+            gainSteps.push_back(ramping ? -0.001f : 0.0f);
+            gainTargets.push_back(ramping ? gains.back() - 0.5f : gains.back());
+            depths.push_back(0.5f);
+            depthSteps.push_back(ramping ? 0.0005f : 0.0f);
+            depthTargets.push_back(ramping ? 0.75f : 0.5f);
+            rampRemaining.push_back(ramping ? 500 : 0);
+        }
+
+        GainKernels::StreamState state;
+        state.shape = (GainKernels::StreamState::Shape) (numChannels % 4);
+        state.phase = phases.data();
+        state.increment = increments.data();
+        state.gain = gains.data();
+        state.gainStep = gainSteps.data();
+        state.gainTarget = gainTargets.data();
+        state.depth = depths.data();
+        state.depthStep = depthSteps.data();
+        state.depthTarget = depthTargets.data();
+        state.rampRemaining = rampRemaining.data();
+
+        kernels.processStreams(channels, state, 0, numChannels, 0, length);
+    }
+
+    template <typename SampleType>
+    void compare(const KernelDispatch::KernelTable& baseline, const KernelDispatch::KernelTable& candidate,
+                 int numChannels, int length)
+    {
+        // Inputs past full scale, so the soft clipper does some work
+        juce::AudioBuffer<SampleType> source(numChannels, length), envelopes(2, length);
+        auto& random = getRandom();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int sample = 0; sample < length; ++sample)
+                source.setSample(channel, sample, (SampleType) (random.nextFloat() * 4.0f - 2.0f));
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int sample = 0; sample < length; ++sample)
+                envelopes.setSample(channel, sample, (SampleType) random.nextFloat());
+
+        const auto description = juce::String(numChannels) + " channels, " + juce::String(length) + " samples";
+        const GainKernels::OutputStage stage { GainKernels::OutputStage::Mode::softClip, 0.9f };
+
+        for (int kernel = 0; kernel < 6; ++kernel)
+        {
+            juce::AudioBuffer<SampleType> expected(source), actual(source);
+            GainKernels::LevelAccumulator expectedLevels[2], actualLevels[2];
+            bool expectedSilent = false, actualSilent = false;
+
+            auto run = [&](const KernelDispatch::KernelSet<SampleType>& kernels, juce::AudioBuffer<SampleType>& buffer,
+                           GainKernels::LevelAccumulator* levels, bool& silent)
+            {
+                auto* channels = buffer.getArrayOfWritePointers();
+
+                switch (kernel)
+                {
+                    case 0:  kernels.applyGain(channels, numChannels, 0, (SampleType) 1.7, length, &levels[0], &levels[1], &stage); break;
+                    case 1:  kernels.applyEnvelope(channels, numChannels, 0, envelopes.getReadPointer(0), length, &levels[0], &levels[1], &stage); break;
+                    case 2:  kernels.measureLevels(channels, numChannels, 0, length, levels[0]); break;
+                    case 3:  silent = kernels.isSilent(buffer.getArrayOfReadPointers(), numChannels, 0, length, (SampleType) 1.99); break;
+                    case 4:  runStreams(kernels, channels, numChannels, length); break;
+                    default:
+                        if (numChannels == 2)
+                            kernels.applyStereoEnvelopes(channels, 0, envelopes.getReadPointer(0), envelopes.getReadPointer(1),
+                                                         length, true, &levels[0], &levels[1], &stage);
+                        break;
+                }
+            };
+
+            run(baseline.get<SampleType>(), expected, expectedLevels, expectedSilent);
+            run(candidate.get<SampleType>(), actual, actualLevels, actualSilent);
+
+            auto identical = expectedSilent == actualSilent;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                identical = identical && std::memcmp(expected.getReadPointer(channel), actual.getReadPointer(channel),
+                                                     sizeof(SampleType) * (size_t) length) == 0;
+
+            for (int i = 0; i < 2; ++i)
+                identical = identical && expectedLevels[i].peak == actualLevels[i].peak
+                                      && expectedLevels[i].sumSquares == actualLevels[i].sumSquares
+                                      && expectedLevels[i].numSamples == actualLevels[i].numSamples;
+
+            expect(identical, "kernel " + juce::String(kernel) + ", " + description);
+        }
+    }
+};
+
+//==============================================================================
+class ModulationLfoTests : public juce::UnitTest
+{
+public:
+    ModulationLfoTests() : juce::UnitTest("Modulation LFO", "Kernels") {}
+
+    void runTest() override
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numSamples = 48000;
+        std::vector<float> main((size_t) numSamples), lagging((size_t) numSamples);
+
+        beginTest("Sine follows std::sin at audio rate");
+        {
+            ModulationLfo lfo;
+            lfo.prepare(sampleRate);
+            lfo.setFrequency(440.0f);
+            lfo.process(main.data(), numSamples);
+
+            expectLessThan(errorAgainstSine(main, 440.0, 0.0, sampleRate), 2.0e-6);
+        }
+
+        beginTest("Control-rate sine stays close to std::sin");
+        {
+            ModulationLfo lfo;
+            lfo.prepare(sampleRate);
+            lfo.setFrequency(5.0f);
+            lfo.setControlRateInterval(16);
+            lfo.process(main.data(), numSamples);
+
+            expectLessThan(errorAgainstSine(main, 5.0, 0.0, sampleRate), 2.0e-5);
+        }
+
+        beginTest("Lagging output trails by the phase offset");
+        {
+            for (auto interval : { 1, 16 })
+            {
+                ModulationLfo lfo;
+                lfo.prepare(sampleRate);
+                lfo.setFrequency(3.0f);
+                lfo.setControlRateInterval(interval);
+                lfo.setPhaseOffset(0.25);
+                lfo.process(main.data(), lagging.data(), numSamples);
+
+                expectLessThan(errorAgainstSine(main, 3.0, 0.0, sampleRate), 2.0e-5);
+                expectLessThan(errorAgainstSine(lagging, 3.0, 0.25, sampleRate), 2.0e-5);
+            }
+        }
+
+        beginTest("Half a cycle of offset gives opposite outputs");
+        {
+            ModulationLfo lfo;
+            lfo.prepare(sampleRate);
+            lfo.setFrequency(1000.0f);
+            lfo.setPhaseOffset(0.5);
+            lfo.process(main.data(), lagging.data(), numSamples);
+
+            double error = 0.0;
+
+            for (int i = 0; i < numSamples; ++i)
+                error = juce::jmax(error, (double) std::abs(main[(size_t) i] + lagging[(size_t) i]));
+
+            expectLessThan(error, 1.0e-6);
+        }
+
+        beginTest("Advancing matches processing the same number of samples");
+        {
+            ModulationLfo processed, advanced;
+
+            for (auto* lfo : { &processed, &advanced })
+            {
+                lfo->prepare(sampleRate);
+                lfo->setFrequency(2.0f);
+                lfo->setControlRateInterval(16);
+            }
+
+            processed.process(main.data(), 1001);
+            advanced.advance(1001);
+
+            expectWithinAbsoluteError(processed.getNextSample(), advanced.getNextSample(), 1.0e-6f);
+        }
+    }
+
+private:
+    static double errorAgainstSine(const std::vector<float>& values, double frequency, double lag, double sampleRate)
+    {
+        double error = 0.0;
+
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            const auto expected = std::sin(juce::MathConstants<double>::twoPi * ((double) i * frequency / sampleRate - lag));
+            error = juce::jmax(error, std::abs((double) values[i] - expected));
+        }
+
+        return error;
+    }
+};
+
+//==============================================================================
+class TruePeakMeterTests : public juce::UnitTest
+{
+public:
+    TruePeakMeterTests() : juce::UnitTest("True-peak meter", "Kernels") {}
+
+    void runTest() override
+    {
+        beginTest("Finds the peak between samples");
+        {
+            // A quarter-rate sine sampled 45 degrees off its peaks: every sample is at
+            // 0.707, the waveform reaches 1 halfway between them
+            std::vector<float> signal(4096);
+
+            for (size_t i = 0; i < signal.size(); ++i)
+                signal[i] = (float) std::sin(juce::MathConstants<double>::halfPi * (double) i + juce::MathConstants<double>::pi / 4.0);
+
+            TruePeakMeter meter;
+            meter.reset();
+
+            // Split across calls, so the history between blocks is exercised too
+            auto peak = 0.0f;
+
+            for (int start = 0; start < 4096; start += 100)
+                peak = juce::jmax(peak, meter.process(0, signal.data() + start, juce::jmin(100, 4096 - start)));
+
+            expectWithinAbsoluteError(peak, 1.0f, 0.05f);
+        }
+
+        beginTest("Silence reads zero");
+        {
+            std::vector<double> silence(512, 0.0);
+            TruePeakMeter meter;
+            meter.reset();
+            expectEquals(meter.process(3, silence.data(), 512), 0.0f);
+        }
+    }
+};
+
+static GainKernelTests gainKernelTests;
+static KernelDispatchTests kernelDispatchTests;
+static ModulationLfoTests modulationLfoTests;
+static TruePeakMeterTests truePeakMeterTests;
@@ -0,0 +1,43 @@
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <iostream>
+
+//==============================================================================
+/**
+ * SimpleGainTests runs the juce::UnitTest suites linked into it and exits
+ * with an error if any expectation failed. ctest runs one category per test.
+ *
+ * Usage:
+ *   SimpleGainTests [--category=Kernels|Processor|State|Performance|Headless|MultiStream] [--seed=<n>]
+ */
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    // A fixed seed keeps the noise inputs the same from run to run
+    const auto seed = args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : (juce::int64) 0x5147;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+
+    if (args.containsOption("--category"))
+        runner.runTestsInCategory(args.getValueForOption("--category"), seed);
+    else
+        runner.runAllTests(seed);
+
+    int numTests = 0, numFailures = 0;
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+    {
+        numTests += runner.getResult(i)->passes + runner.getResult(i)->failures;
+        numFailures += runner.getResult(i)->failures;
+    }
+
+    if (numTests == 0)
+    {
+        std::cerr << "No tests were run" << std::endl;
+        return 1;
+    }
+
+    return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,209 @@
+#include "TestUtilities.h"
+#include "MultiStreamEngine.h"
+
+//==============================================================================
+/**
+ * MultiStreamEngine against a per-sample model of each stream, parameter
+ * ramps, and the split across worker threads.
+ */
+class MultiStreamTests : public juce::UnitTest
+{
+public:
+    MultiStreamTests() : juce::UnitTest("Multi-stream engine", "MultiStream") {}
+
+    void runTest() override
+    {
+        constexpr double sampleRate = 48000.0;
+
+        beginTest("Each stream gets its own gain");
+        {
+            constexpr int numStreams = 300;
+            MultiStreamEngine engine(numStreams, 1);
+
+            for (int stream = 0; stream < numStreams; ++stream)
+                engine.setGain(stream, -0.05f * (float) stream);
+
+            engine.prepare(sampleRate);
+
+            juce::AudioBuffer<float> buffer(numStreams, 256);
+            fill(buffer, 0.5f);
+            engine.process(buffer);
+
+            for (int stream = 0; stream < numStreams; ++stream)
+            {
+                const auto expected = 0.5f * juce::Decibels::decibelsToGain(-0.05f * (float) stream);
+                expectEquals(buffer.getSample(stream, 0), expected);
+                expectEquals(buffer.getSample(stream, 255), expected);
+            }
+        }
+
+        beginTest("Modulated streams follow gain * (1 + depth * sin)");
+        {
+            // Two groups, the second one partly filled
+            constexpr int numStreams = GainKernels::streamGroupSize + 6;
+            constexpr int blockSize = 480;
+            MultiStreamEngine engine(numStreams, 1);
+            Model model[numStreams];
+
+            for (int stream = 0; stream < numStreams; ++stream)
+            {
+                model[stream] = { -0.1f * (float) stream, (float) (stream % 5) * 0.25f, 0.5f + 0.3f * (float) stream,
+                                  (float) stream / (float) numStreams };
+                engine.setGain(stream, model[stream].gainDecibels);
+                engine.setModDepth(stream, model[stream].depth);
+                engine.setModFrequency(stream, model[stream].frequency);
+                engine.setModPhase(stream, model[stream].phase);
+            }
+
+            engine.prepare(sampleRate);
+
+            juce::AudioBuffer<float> buffer(numStreams, blockSize);
+            auto maxError = 0.0;
+
+            for (int block = 0; block < 4; ++block)
+            {
+                fill(buffer, 1.0f);
+                engine.process(buffer);
+
+                for (int stream = 0; stream < numStreams; ++stream)
+                    for (int sample = 0; sample < blockSize; ++sample)
+                        maxError = juce::jmax(maxError, std::abs(buffer.getSample(stream, sample)
+                                                                 - model[stream].at(block * blockSize + sample, sampleRate)));
+            }
+
+            // Tremolo rates are evaluated every 16 samples and interpolated
+            expectLessThan(maxError, 1.0e-3);
+        }
+
+        beginTest("Audio-rate LFOs are evaluated every sample");
+        {
+            constexpr int blockSize = 512;
+            MultiStreamEngine engine(2, 1);
+            const Model model[] = { { -3.0f, 1.0f, 3000.0f, 0.1f }, { 0.0f, 0.5f, 2.0f, 0.0f } };
+
+            for (int stream = 0; stream < 2; ++stream)
+            {
+                engine.setGain(stream, model[stream].gainDecibels);
+                engine.setModDepth(stream, model[stream].depth);
+                engine.setModFrequency(stream, model[stream].frequency);
+                engine.setModPhase(stream, model[stream].phase);
+            }
+
+            engine.prepare(sampleRate);
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            fill(buffer, 1.0f);
+            engine.process(buffer);
+
+            // The slow stream shares the fast one's group, so both are exact
+            for (int stream = 0; stream < 2; ++stream)
+            {
+                auto maxError = 0.0;
+
+                for (int sample = 0; sample < blockSize; ++sample)
+                    maxError = juce::jmax(maxError, std::abs(buffer.getSample(stream, sample) - model[stream].at(sample, sampleRate)));
+
+                expectLessThan(maxError, 1.0e-5);
+            }
+        }
+
+        beginTest("Gain and depth changes ramp to their targets");
+        {
+            MultiStreamEngine engine(1, 1);
+            engine.prepare(sampleRate);
+            engine.setGain(0, -6.0f);
+
+            const auto target = juce::Decibels::decibelsToGain(-6.0f);
+            const auto rampLength = juce::roundToInt(0.02 * sampleRate);
+            juce::AudioBuffer<float> buffer(1, rampLength + 64);
+
+            fill(buffer, 1.0f);
+            engine.process(buffer);
+            expect(buffer.getSample(0, 1) < 1.0f && buffer.getSample(0, 1) > target);
+            expect(buffer.getSample(0, rampLength / 2) > target);
+            expectWithinAbsoluteError(buffer.getSample(0, rampLength), target, 1.0e-5f);
+
+            // Once the ramp is over the gain sits exactly on its target
+            fill(buffer, 1.0f);
+            engine.process(buffer);
+            expectEquals(buffer.getSample(0, 0), target);
+        }
+
+        beginTest("Worker threads don't change the output");
+        {
+            constexpr int numStreams = 1500;
+            MultiStreamEngine single(numStreams, 1), threaded(numStreams, 4);
+            expectEquals(threaded.getNumThreads(), 4);
+
+            auto& random = getRandom();
+
+            for (int stream = 0; stream < numStreams; ++stream)
+            {
+                const auto gain = random.nextFloat() * -24.0f;
+                const auto depth = random.nextFloat();
+                const auto frequency = 0.1f + random.nextFloat() * 20.0f;
+                const auto phase = random.nextFloat();
+
+                for (auto* engine : { &single, &threaded })
+                {
+                    engine->setGain(stream, gain);
+                    engine->setModDepth(stream, depth);
+                    engine->setModFrequency(stream, frequency);
+                    engine->setModPhase(stream, phase);
+                }
+            }
+
+            for (auto* engine : { &single, &threaded })
+                engine->prepare(sampleRate);
+
+            juce::AudioBuffer<double> expected(numStreams, 300), actual(numStreams, 300);
+
+            for (int block = 0; block < 3; ++block)
+            {
+                // A gain change mid-way, so the ramping path is split as well
+                if (block == 1)
+                    for (auto* engine : { &single, &threaded })
+                        engine->setGain(7, 3.0f);
+
+                fill(expected, 0.25);
+                fill(actual, 0.25);
+                single.process(expected);
+                threaded.process(actual);
+
+                auto identical = true;
+
+                for (int stream = 0; stream < numStreams; ++stream)
+                    identical = identical && std::memcmp(expected.getReadPointer(stream), actual.getReadPointer(stream),
+                                                         sizeof(double) * (size_t) expected.getNumSamples()) == 0;
+
+                expect(identical, "block " + juce::String(block));
+            }
+        }
+    }
+
+private:
+    //==============================================================================
+    // One stream as the engine should render it
+    struct Model
+    {
+        float gainDecibels = 0.0f;
+        float depth = 0.0f;
+        float frequency = 1.0f;
+        float phase = 0.0f;
+
+        double at(int sample, double sampleRate) const
+        {
+            const auto lfo = std::sin(juce::MathConstants<double>::twoPi * (phase + sample * frequency / sampleRate));
+            return juce::Decibels::decibelsToGain((double) gainDecibels) * (1.0 + depth * lfo);
+        }
+    };
+
+    template <typename SampleType>
+    static void fill(juce::AudioBuffer<SampleType>& buffer, SampleType value)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            juce::FloatVectorOperations::fill(buffer.getWritePointer(channel), value, buffer.getNumSamples());
+    }
+};
+
+static MultiStreamTests multiStreamTests;
@@ -0,0 +1,173 @@
+#include "TestUtilities.h"
+#include <chrono>
+
+//==============================================================================
+/**
+ * Performance gates: each case processes a few seconds of stereo or 16-channel
+ * audio in 512-sample blocks at 48 kHz and fails if the fastest of several runs
+ * costs more than its ceiling in ns per sample frame.
+ *
+ * The ceilings are loose enough for any recent x86-64 or ARM64 machine running
+ * a Release build, so they catch lost vectorisation or a kernel falling back to
+ * a slower path rather than small drifts. For tighter gates on a given machine:
+ *
+ *   SIMPLEGAIN_PERF_RESULTS=<file>     writes this run's timings as JSON lines
+ *   SIMPLEGAIN_PERF_BASELINE=<file>    fails any case more than the tolerance
+ *                                      slower than in that file
+ *   SIMPLEGAIN_PERF_TOLERANCE=<ratio>  allowed slowdown against the baseline (0.25)
+ *   SIMPLEGAIN_PERF_GATE_SCALE=<x>     multiplies every ceiling (1)
+ *
+ * Debug builds only report their timings.
+ */
+class PerformanceTests : public juce::UnitTest
+{
+public:
+    PerformanceTests() : juce::UnitTest("Performance gates", "Performance") {}
+
+    void runTest() override
+    {
+        struct GateCase
+        {
+            const char* name;
+            int numChannels;
+            std::function<void(SimpleGainProcessor&)> setUp;
+            double ceilingNsPerSample;
+        };
+
+        auto set = [](const juce::String& parameterID, float value)
+        {
+            return [parameterID, value](SimpleGainProcessor& processor) { TestUtilities::setParameter(processor, parameterID, value); };
+        };
+
+        auto modulated = [](float frequency)
+        {
+            return [frequency](SimpleGainProcessor& processor)
+            {
+                TestUtilities::setParameter(processor, SimpleGainProcessor::modFreqID, frequency);
+                TestUtilities::setParameter(processor, SimpleGainProcessor::modDepthID, 1.0f);
+            };
+        };
+
+        const GateCase cases[] = {
+            { "stereo-static",      2,  set(SimpleGainProcessor::gainID, -6.0f),                       4.0 },
+            { "stereo-modulated",   2,  modulated(5.0f),                                              10.0 },
+            { "stereo-audio-rate",  2,  modulated(440.0f),                                            15.0 },
+            { "stereo-auto-pan",    2,  [&](SimpleGainProcessor& p) { modulated(2.0f)(p);
+                                                                       set(SimpleGainProcessor::stereoPhaseID, 180.0f)(p); }, 15.0 },
+            { "stereo-mid-side",    2,  [&](SimpleGainProcessor& p) { modulated(5.0f)(p);
+                                                                       set(SimpleGainProcessor::stereoModeID, 1.0f)(p);
+                                                                       set(SimpleGainProcessor::sideGainID, 3.0f)(p); }, 15.0 },
+            { "stereo-soft-clip",   2,  set(SimpleGainProcessor::clipModeID, 1.0f),                   15.0 },
+            { "16ch-modulated",     16, modulated(5.0f),                                              50.0 },
+            { "16ch-silent",        16, modulated(5.0f),                                               5.0 }
+        };
+
+        const auto scale = getEnvironmentValue("SIMPLEGAIN_PERF_GATE_SCALE", 1.0);
+        const auto tolerance = getEnvironmentValue("SIMPLEGAIN_PERF_TOLERANCE", 0.25);
+        const auto baseline = readBaseline();
+        juce::StringArray results;
+
+        for (auto& gateCase : cases)
+        {
+            beginTest(gateCase.name);
+
+            const auto silent = juce::String(gateCase.name).endsWith("silent");
+            const auto nsPerSample = measure(gateCase.numChannels, gateCase.setUp, silent);
+
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty("case", gateCase.name);
+            entry->setProperty("ns_per_sample", nsPerSample);
+            results.add(juce::JSON::toString(juce::var(entry), true));
+
+            logMessage(juce::String(gateCase.name) + ": " + juce::String(nsPerSample, 3) + " ns/sample");
+
+           #if JUCE_DEBUG
+            logMessage("Debug build, not gated");
+           #else
+            expectLessThan(nsPerSample, gateCase.ceilingNsPerSample * scale, "ceiling");
+
+            if (baseline.contains(gateCase.name))
+                expectLessThan(nsPerSample, (double) baseline[gateCase.name] * (1.0 + tolerance), "baseline");
+           #endif
+        }
+
+        const auto resultsPath = juce::SystemStats::getEnvironmentVariable("SIMPLEGAIN_PERF_RESULTS", {});
+
+        if (resultsPath.isNotEmpty())
+            juce::File::getCurrentWorkingDirectory().getChildFile(resultsPath).replaceWithText(results.joinIntoString("\n") + "\n");
+    }
+
+private:
+    static double getEnvironmentValue(const juce::String& name, double defaultValue)
+    {
+        const auto value = juce::SystemStats::getEnvironmentVariable(name, {});
+        return value.isNotEmpty() ? value.getDoubleValue() : defaultValue;
+    }
+
+    // Case name -> ns/sample from a file written through SIMPLEGAIN_PERF_RESULTS
+    static juce::NamedValueSet readBaseline()
+    {
+        juce::NamedValueSet baseline;
+        const auto path = juce::SystemStats::getEnvironmentVariable("SIMPLEGAIN_PERF_BASELINE", {});
+
+        if (path.isEmpty())
+            return baseline;
+
+        juce::StringArray lines;
+        lines.addLines(juce::File::getCurrentWorkingDirectory().getChildFile(path).loadFileAsString());
+
+        for (auto& line : lines)
+        {
+            const auto entry = juce::JSON::parse(line);
+
+            if (entry.hasProperty("case"))
+                baseline.set(juce::Identifier(entry["case"].toString()), entry["ns_per_sample"]);
+        }
+
+        return baseline;
+    }
+
+    // Fastest of several runs, in ns per sample frame
+    double measure(int numChannels, const std::function<void(SimpleGainProcessor&)>& setUp, bool silent)
+    {
+        constexpr int blockSize = 512;
+        constexpr int numBlocks = 256;
+        constexpr int numRuns = 7;
+
+        SimpleGainProcessor processor;
+        setUp(processor);
+
+        if (! TestUtilities::prepare<float>(processor, numChannels, 48000.0, blockSize))
+        {
+            expect(false, "layout not accepted");
+            return 0.0;
+        }
+
+        juce::AudioBuffer<float> source(numChannels, blockSize * numBlocks);
+        juce::AudioBuffer<float> tape(numChannels, blockSize * numBlocks);
+
+        if (silent)
+            source.clear();
+        else
+            TestUtilities::fillWithNoise(source, getRandom(), 0.5f);
+
+        auto best = std::numeric_limits<double>::max();
+
+        for (int run = 0; run < numRuns; ++run)
+        {
+            // A fresh copy every run, so the signal never decays to silence
+            tape.makeCopyOf(source, true);
+
+            const auto start = std::chrono::steady_clock::now();
+            TestUtilities::processInBlocks(processor, tape, blockSize);
+            const auto end = std::chrono::steady_clock::now();
+
+            const auto ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            best = juce::jmin(best, ns / tape.getNumSamples());
+        }
+
+        return best;
+    }
+};
+
+static PerformanceTests performanceTests;
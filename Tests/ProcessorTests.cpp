@@ -0,0 +1,388 @@
+#include "ReferenceProcessor.h"
+#include "TestUtilities.h"
+
+//==============================================================================
+/**
+ * Golden-output tests: SimpleGainProcessor against ReferenceProcessor over
+ * block sizes, channel counts, precisions and parameter automation.
+ *
+ * Tolerances, at full-scale input:
+ *   - Unmodulated gain, static or ramping: exact. Both apply the same
+ *     single-precision gain ramp with one multiply per sample.
+ *   - Sine modulation: 1e-4 per unit of gain. The LFO's table and control-rate
+ *     interpolation stay within 2e-5, the rest is single-precision rounding of
+ *     the envelope.
+ *   - Oversampled modulation: output RMS within 1%, since the half-band filters
+ *     shift the envelope against the signal by part of their latency.
+ */
+class ProcessorGoldenTests : public juce::UnitTest
+{
+public:
+    ProcessorGoldenTests() : juce::UnitTest("Processor golden output", "Processor") {}
+
+    void runTest() override
+    {
+        using Settings = ReferenceProcessor::Settings;
+
+        const juce::Array<int> irregularBlocks { 1, 17, 64, 512, 333, 128 };
+        const int channelCounts[] = { 1, 2, 6, 16 };
+
+        beginTest("Unity passes the input through unchanged");
+        {
+            for (auto numChannels : channelCounts)
+            {
+                expectEquals(compare<float>(numChannels, irregularBlocks, {}), 0.0, describe(numChannels));
+                expectEquals(compare<double>(numChannels, irregularBlocks, {}), 0.0, describe(numChannels));
+            }
+        }
+
+        beginTest("Static and automated gain match exactly");
+        {
+            auto automateGain = [](int blockIndex, Settings& settings)
+            {
+                const float gains[] = { -6.0f, -12.5f, 3.0f, 0.0f, -40.0f };
+
+                if (blockIndex % 5 != 0)
+                    return false;
+
+                settings.gainDecibels = gains[(blockIndex / 5) % 5];
+                return true;
+            };
+
+            Settings halfGain;
+            halfGain.gainDecibels = -6.0f;
+
+            for (auto numChannels : channelCounts)
+            {
+                expectEquals(compare<float>(numChannels, { 512 }, halfGain), 0.0, describe(numChannels));
+                expectEquals(compare<float>(numChannels, irregularBlocks, {}, automateGain), 0.0, describe(numChannels));
+                expectEquals(compare<double>(numChannels, irregularBlocks, {}, automateGain), 0.0, describe(numChannels));
+            }
+        }
+
+        beginTest("Modulation matches the reference");
+        {
+            auto automateDepth = [](int blockIndex, Settings& settings)
+            {
+                if (blockIndex % 7 != 3)
+                    return false;
+
+                settings.modDepth = settings.modDepth > 0.5f ? 0.25f : 1.0f;
+                settings.gainDecibels = settings.modDepth > 0.5f ? -6.0f : 0.0f;
+                return true;
+            };
+
+            // Slow enough for the control-rate LFO, and fast enough for the per-sample one
+            for (auto frequency : { 5.0f, 440.0f })
+            {
+                Settings settings;
+                settings.modFreq = frequency;
+                settings.modDepth = 0.5f;
+
+                for (auto numChannels : channelCounts)
+                {
+                    const auto description = describe(numChannels) + ", " + juce::String(frequency) + " Hz";
+                    expectLessThan(compare<float>(numChannels, irregularBlocks, settings, automateDepth), 2.0e-4, description);
+                    expectLessThan(compare<double>(numChannels, irregularBlocks, settings, automateDepth), 2.0e-4, description);
+                }
+            }
+        }
+
+        beginTest("Stereo modes match the reference");
+        {
+            Settings autoPan;
+            autoPan.modFreq = 2.0f;
+            autoPan.modDepth = 1.0f;
+            autoPan.stereoPhaseDegrees = 180.0f;
+
+            Settings midSide;
+            midSide.modFreq = 6.0f;
+            midSide.modDepth = 0.5f;
+            midSide.midSide = true;
+            midSide.stereoPhaseDegrees = 90.0f;
+            midSide.midGainDecibels = -3.0f;
+            midSide.sideGainDecibels = 4.0f;
+
+            Settings midSideGainOnly;
+            midSideGainOnly.midSide = true;
+
+            auto automateSide = [](int blockIndex, Settings& settings)
+            {
+                if (blockIndex % 4 != 1)
+                    return false;
+
+                settings.sideGainDecibels = settings.sideGainDecibels > 0.0f ? -12.0f : 6.0f;
+                return true;
+            };
+
+            // Gain up to 2 from the envelope and 1.6 from the side gain
+            expectLessThan(compare<float>(2, irregularBlocks, autoPan), 2.0e-4, "auto-pan");
+            expectLessThan(compare<double>(2, irregularBlocks, autoPan), 2.0e-4, "auto-pan");
+            expectLessThan(compare<float>(2, irregularBlocks, midSide), 4.0e-4, "mid/side");
+            expectLessThan(compare<double>(2, irregularBlocks, midSide), 4.0e-4, "mid/side");
+            expectLessThan(compare<float>(2, irregularBlocks, midSideGainOnly, automateSide), 1.0e-6, "mid/side gains");
+
+            // Other layouts ignore the stereo settings and modulate every channel alike
+            auto withoutStereo = autoPan;
+            withoutStereo.stereoPhaseDegrees = 0.0f;
+            expectLessThan(compare<float>(6, irregularBlocks, autoPan, {}, &withoutStereo), 2.0e-4, "5.1");
+        }
+
+        beginTest("Silent gaps keep the LFO in phase");
+        {
+            Settings settings;
+            settings.modFreq = 5.0f;
+            settings.modDepth = 1.0f;
+
+            // A second of silence in the middle is skipped, not processed
+            auto silenceMiddle = [](juce::AudioBuffer<float>& input)
+            {
+                for (int channel = 0; channel < input.getNumChannels(); ++channel)
+                    juce::FloatVectorOperations::clear(input.getWritePointer(channel, 20000), 48000);
+            };
+
+            expectLessThan(compare<float>(2, irregularBlocks, settings, {}, nullptr, 96000, silenceMiddle), 2.0e-4);
+        }
+
+        beginTest("Quiet input boosted above the silence floor is processed");
+        {
+            Settings boosted;
+            boosted.gainDecibels = 24.0f;
+
+            // Around -110 dBFS in, so about -86 dBFS out
+            auto makeQuiet = [](juce::AudioBuffer<float>& input)
+            {
+                input.applyGain(3.0e-6f);
+            };
+
+            expectEquals(compare<float>(2, irregularBlocks, boosted, {}, nullptr, 24000, makeQuiet), 0.0);
+        }
+
+        beginTest("Oversampling adds exactly the reported latency");
+        {
+            for (auto choice : { 1, 2, 3 })
+            {
+                SimpleGainProcessor processor;
+                TestUtilities::setParameter(processor, SimpleGainProcessor::gainID, -6.0f);
+                TestUtilities::setParameter(processor, SimpleGainProcessor::oversamplingID, (float) choice);
+                TestUtilities::prepare<float>(processor, 2, 48000.0, 256);
+
+                const auto latency = processor.getLatencySamples();
+                const auto gain = juce::Decibels::decibelsToGain(TestUtilities::getParameter(processor, SimpleGainProcessor::gainID));
+                expectGreaterThan(latency, 0);
+
+                juce::AudioBuffer<float> input(2, 4096);
+                TestUtilities::fillWithNoise(input, getRandom());
+                juce::AudioBuffer<float> output(input);
+                TestUtilities::processInBlocks(processor, output, 256);
+
+                double error = 0.0;
+
+                for (int channel = 0; channel < 2; ++channel)
+                    for (int sample = 0; sample < 4096; ++sample)
+                    {
+                        const auto expected = sample < latency ? 0.0f : input.getSample(channel, sample - latency) * gain;
+                        error = juce::jmax(error, (double) std::abs(output.getSample(channel, sample) - expected));
+                    }
+
+                expectEquals(error, 0.0, "factor " + juce::String(1 << choice));
+            }
+        }
+
+        beginTest("Oversampled audio-rate modulation keeps its level");
+        {
+            Settings settings;
+            settings.modFreq = 1000.0f;
+            settings.modDepth = 1.0f;
+
+            SimpleGainProcessor processor;
+            apply(processor, settings);
+            TestUtilities::setParameter(processor, SimpleGainProcessor::oversamplingID, 2.0f);
+            TestUtilities::prepare<float>(processor, 2, 48000.0, 512);
+
+            ReferenceProcessor reference;
+            reference.prepare(48000.0, read(processor));
+
+            // A tone well inside the filters' passband whose sidebands don't land on it, so the
+            // level doesn't depend on the envelope's phase against the signal
+            juce::AudioBuffer<float> input(2, 48000);
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int sample = 0; sample < input.getNumSamples(); ++sample)
+                    input.setSample(channel, sample, 0.5f * (float) std::sin(juce::MathConstants<double>::twoPi * 440.0 * sample / 48000.0));
+
+            juce::AudioBuffer<float> output(input), expected(input);
+            TestUtilities::processInBlocks(processor, output, 512);
+            reference.process(expected, 0, expected.getNumSamples());
+
+            // Past the filters' start-up
+            const auto start = 4096;
+            const auto length = input.getNumSamples() - start;
+            const auto outputRms = output.getRMSLevel(0, start, length);
+            const auto expectedRms = expected.getRMSLevel(0, start, length);
+
+            expectWithinAbsoluteError(outputRms, expectedRms, 0.01f * expectedRms);
+        }
+
+        beginTest("Program changes ramp to the preset");
+        {
+            SimpleGainProcessor processor;
+            TestUtilities::prepare<float>(processor, 2, 48000.0, 512);
+
+            // A bank file in the user's folder replaces the built-in presets
+            if (processor.getProgramName(1) != PresetBank::getBuiltInPresets()[1].name)
+            {
+                logMessage("Skipped: a preset bank file is installed");
+                return;
+            }
+
+            ReferenceProcessor reference;
+            reference.prepare(48000.0, read(processor));
+
+            juce::AudioBuffer<float> output(2, 24000);
+            TestUtilities::fillWithNoise(output, getRandom());
+            juce::AudioBuffer<float> expected(output);
+
+            // "Pad -6 dB" only differs from the defaults in its gain
+            TestUtilities::processInBlocks(processor, output, { 512 }, [&](int blockIndex, int start, int size)
+            {
+                if (blockIndex == 4)
+                {
+                    processor.setCurrentProgram(1);
+
+                    Settings settings;
+                    settings.gainDecibels = PresetBank::getBuiltInPresets()[1].values[0];
+                    reference.setTargets(settings);
+                }
+
+                reference.process(expected, start, size);
+            });
+
+            expectEquals(processor.getCurrentProgram(), 1);
+            expectEquals(TestUtilities::maxDifference(output, expected), 0.0);
+        }
+
+        beginTest("Real-time automation applies from the first sample of the next block");
+        {
+            SimpleGainProcessor processor;
+            TestUtilities::prepare<float>(processor, 2, 48000.0, 512);
+            processor.setNonRealtime(false);
+
+            ReferenceProcessor reference;
+            reference.prepare(48000.0, read(processor));
+
+            juce::AudioBuffer<float> output(2, 8192);
+            TestUtilities::fillWithNoise(output, getRandom());
+            juce::AudioBuffer<float> expected(output);
+
+            // Hosts deliver automation just before the block it belongs to, after a gap like this one
+            TestUtilities::processInBlocks(processor, output, { 512 }, [&](int blockIndex, int start, int size)
+            {
+                juce::Thread::sleep(2);
+
+                if (blockIndex == 6)
+                {
+                    TestUtilities::setParameter(processor, SimpleGainProcessor::gainID, -12.0f);
+
+                    Settings settings;
+                    settings.gainDecibels = TestUtilities::getParameter(processor, SimpleGainProcessor::gainID);
+                    reference.setTargets(settings);
+                }
+
+                reference.process(expected, start, size);
+            });
+
+            expectEquals(TestUtilities::maxDifference(output, expected), 0.0);
+        }
+    }
+
+private:
+    using Settings = ReferenceProcessor::Settings;
+    using Automation = std::function<bool(int blockIndex, Settings& settings)>;
+
+    static juce::String describe(int numChannels)
+    {
+        return juce::String(numChannels) + " channels";
+    }
+
+    static void apply(SimpleGainProcessor& processor, const Settings& settings)
+    {
+        TestUtilities::setParameter(processor, SimpleGainProcessor::gainID, settings.gainDecibels);
+        TestUtilities::setParameter(processor, SimpleGainProcessor::modFreqID, settings.modFreq);
+        TestUtilities::setParameter(processor, SimpleGainProcessor::modDepthID, settings.modDepth);
+        TestUtilities::setParameter(processor, SimpleGainProcessor::stereoModeID, settings.midSide ? 1.0f : 0.0f);
+        TestUtilities::setParameter(processor, SimpleGainProcessor::stereoPhaseID, settings.stereoPhaseDegrees);
+        TestUtilities::setParameter(processor, SimpleGainProcessor::midGainID, settings.midGainDecibels);
+        TestUtilities::setParameter(processor, SimpleGainProcessor::sideGainID, settings.sideGainDecibels);
+    }
+
+    // The values the processor ended up with, after each parameter snapped them to its interval
+    static Settings read(SimpleGainProcessor& processor)
+    {
+        Settings settings;
+        settings.gainDecibels = TestUtilities::getParameter(processor, SimpleGainProcessor::gainID);
+        settings.modFreq = TestUtilities::getParameter(processor, SimpleGainProcessor::modFreqID);
+        settings.modDepth = TestUtilities::getParameter(processor, SimpleGainProcessor::modDepthID);
+        settings.midSide = TestUtilities::getParameter(processor, SimpleGainProcessor::stereoModeID) >= 0.5f;
+        settings.stereoPhaseDegrees = TestUtilities::getParameter(processor, SimpleGainProcessor::stereoPhaseID);
+        settings.midGainDecibels = TestUtilities::getParameter(processor, SimpleGainProcessor::midGainID);
+        settings.sideGainDecibels = TestUtilities::getParameter(processor, SimpleGainProcessor::sideGainID);
+        return settings;
+    }
+
+    // Processes noise through both and returns the largest difference. Automation is
+    // called before each block and applied to both when it returns true; referenceSettings
+    // replaces the reference's starting point when the layout ignores some settings.
+    template <typename SampleType>
+    double compare(int numChannels, const juce::Array<int>& blockSizes, const Settings& initial,
+                   Automation automation = {}, const Settings* referenceSettings = nullptr, int numSamples = 24000,
+                   std::function<void(juce::AudioBuffer<float>&)> shapeInput = {})
+    {
+        SimpleGainProcessor processor;
+        apply(processor, initial);
+
+        auto maxBlockSize = 0;
+
+        for (auto size : blockSizes)
+            maxBlockSize = juce::jmax(maxBlockSize, size);
+
+        if (! TestUtilities::prepare<SampleType>(processor, numChannels, 48000.0, maxBlockSize))
+        {
+            expect(false, "layout not accepted: " + describe(numChannels));
+            return 1.0;
+        }
+
+        ReferenceProcessor reference;
+        reference.prepare(48000.0, referenceSettings != nullptr ? *referenceSettings : read(processor));
+
+        juce::AudioBuffer<float> input(numChannels, numSamples);
+        TestUtilities::fillWithNoise(input, getRandom());
+
+        if (shapeInput)
+            shapeInput(input);
+
+        juce::AudioBuffer<SampleType> output(numChannels, numSamples), expected(numChannels, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int sample = 0; sample < numSamples; ++sample)
+                output.setSample(channel, sample, (SampleType) input.getSample(channel, sample));
+
+        expected.makeCopyOf(output);
+        auto settings = initial;
+
+        TestUtilities::processInBlocks(processor, output, blockSizes, [&](int blockIndex, int start, int size)
+        {
+            if (automation && automation(blockIndex, settings))
+            {
+                apply(processor, settings);
+                reference.setTargets(read(processor));
+            }
+
+            reference.process(expected, start, size);
+        });
+
+        return TestUtilities::maxDifference(output, expected);
+    }
+};
+
+static ProcessorGoldenTests processorGoldenTests;
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cmath>
+
+//==============================================================================
+/**
+ * ReferenceProcessor is a deliberately plain model of what SimpleGainProcessor
+ * does to a signal, used as the golden output in the tests.
+ *
+ * It works one sample at a time, in double precision, with none of the block
+ * splitting, tiling, kernel selection, control-rate LFO or silence skipping of
+ * the real processor. It covers the sine LFO at the host rate; the rate and the
+ * stereo phase are fixed at prepare(), while gain, depth and the mid/side gains
+ * ramp like the processor's parameters do. Gains are smoothed with the same
+ * single-precision ramps, so unmodulated output matches the processor exactly.
+ */
+class ReferenceProcessor
+{
+public:
+    struct Settings
+    {
+        float gainDecibels = 0.0f;
+        float modFreq = 1.0f;
+        float modDepth = 0.0f;
+        bool midSide = false;
+        float stereoPhaseDegrees = 0.0f;
+        float midGainDecibels = 0.0f;
+        float sideGainDecibels = 0.0f;
+    };
+
+    void prepare(double newSampleRate, const Settings& settings)
+    {
+        sampleRate = newSampleRate;
+        phase = 0.0;
+        phaseIncrement = settings.modFreq / sampleRate;
+        phaseOffset = settings.stereoPhaseDegrees / 360.0;
+
+        gain.reset(sampleRate, 0.02);
+        depth.reset(sampleRate, 0.02);
+        midGain.reset(sampleRate, 0.02);
+        sideGain.reset(sampleRate, 0.02);
+
+        gain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(settings.gainDecibels));
+        depth.setCurrentAndTargetValue(settings.modDepth);
+        midGain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(settings.midGainDecibels));
+        sideGain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(settings.sideGainDecibels));
+        midSide = settings.midSide;
+    }
+
+    // New targets from the next sample on; the rate and stereo phase are left as they are
+    void setTargets(const Settings& settings)
+    {
+        gain.setTargetValue(juce::Decibels::decibelsToGain(settings.gainDecibels));
+        depth.setTargetValue(settings.modDepth);
+        midGain.setTargetValue(juce::Decibels::decibelsToGain(settings.midGainDecibels));
+        sideGain.setTargetValue(juce::Decibels::decibelsToGain(settings.sideGainDecibels));
+        midSide = settings.midSide;
+    }
+
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
+    {
+        const auto numChannels = buffer.getNumChannels();
+
+        for (int sample = startSample; sample < startSample + numSamples; ++sample)
+        {
+            const auto g = (double) gain.getNextValue();
+            const auto d = (double) depth.getNextValue();
+            const auto m = (double) midGain.getNextValue();
+            const auto s = (double) sideGain.getNextValue();
+
+            // Left (or mid) follows the LFO, right (or side) lags it by the stereo phase
+            const auto lfo = std::sin(juce::MathConstants<double>::twoPi * phase);
+            const auto laggingLfo = std::sin(juce::MathConstants<double>::twoPi * (phase - phaseOffset));
+            phase += phaseIncrement;
+            phase -= std::floor(phase);
+
+            const auto first = g * (1.0 + d * lfo);
+            const auto second = g * (1.0 + d * laggingLfo);
+
+            if (numChannels == 2)
+            {
+                const auto left = (double) buffer.getSample(0, sample);
+                const auto right = (double) buffer.getSample(1, sample);
+
+                if (midSide)
+                {
+                    const auto mid = 0.5 * (left + right) * first * m;
+                    const auto side = 0.5 * (left - right) * second * s;
+
+                    buffer.setSample(0, sample, (SampleType) (mid + side));
+                    buffer.setSample(1, sample, (SampleType) (mid - side));
+                }
+                else
+                {
+                    buffer.setSample(0, sample, (SampleType) (left * first));
+                    buffer.setSample(1, sample, (SampleType) (right * second));
+                }
+
+                continue;
+            }
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                buffer.setSample(channel, sample, (SampleType) ((double) buffer.getSample(channel, sample) * first));
+        }
+    }
+
+private:
+    double sampleRate = 44100.0;
+    double phase = 0.0;
+    double phaseIncrement = 0.0;
+    double phaseOffset = 0.0;
+    bool midSide = false;
+
+    juce::SmoothedValue<float> gain;
+    juce::SmoothedValue<float> depth;
+    juce::SmoothedValue<float> midGain;
+    juce::SmoothedValue<float> sideGain;
+};
@@ -0,0 +1,177 @@
+#include "TestUtilities.h"
+
+//==============================================================================
+/**
+ * Saving and restoring the plugin state, in the binary format and from the
+ * older XML format, and reading preset bank files.
+ */
+class StateTests : public juce::UnitTest
+{
+public:
+    StateTests() : juce::UnitTest("Plugin state", "State") {}
+
+    void runTest() override
+    {
+        beginTest("Binary state round-trips every parameter");
+        {
+            for (int trial = 0; trial < 20; ++trial)
+            {
+                SimpleGainProcessor source, destination;
+                randomise(source);
+
+                juce::MemoryBlock state;
+                source.getStateInformation(state);
+                expect(BinaryState::isBinaryState(state.getData(), (int) state.getSize()));
+
+                destination.setStateInformation(state.getData(), (int) state.getSize());
+                expectMatching(source, destination);
+            }
+        }
+
+        beginTest("Older XML states still load");
+        {
+            SimpleGainProcessor source, destination;
+            randomise(source);
+
+            juce::MemoryBlock state;
+            std::unique_ptr<juce::XmlElement> xml(source.getParameters().copyState().createXml());
+            juce::AudioProcessor::copyXmlToBinary(*xml, state);
+
+            destination.setStateInformation(state.getData(), (int) state.getSize());
+            expectMatching(source, destination);
+        }
+
+        beginTest("States from before a parameter existed give it its default");
+        {
+            SimpleGainProcessor source, destination, defaults;
+            randomise(source);
+            randomise(destination);
+
+            juce::MemoryBlock fullState;
+            source.getStateInformation(fullState);
+
+            // Keep the first eight values, as saved before the stereo parameters
+            constexpr int numOldValues = 8;
+            float values[numOldValues];
+            expectEquals(BinaryState::read(fullState.getData(), (int) fullState.getSize(), values, numOldValues), numOldValues);
+
+            char oldState[BinaryState::getSize(numOldValues)];
+            BinaryState::write(oldState, values, numOldValues);
+            destination.setStateInformation(oldState, (int) sizeof(oldState));
+
+            auto sourceParameters = getParameters(source);
+            auto destinationParameters = getParameters(destination);
+            auto defaultParameters = getParameters(defaults);
+
+            for (int i = 0; i < destinationParameters.size(); ++i)
+            {
+                auto& expected = i < numOldValues ? sourceParameters : defaultParameters;
+                expectWithinAbsoluteError(destinationParameters[i]->getValue(), expected[i]->getValue(), 1.0e-5f,
+                                          destinationParameters[i]->getName(32));
+            }
+        }
+
+        beginTest("Damaged states are ignored or fall back to defaults");
+        {
+            SimpleGainProcessor source, destination;
+            randomise(source);
+            randomise(destination);
+
+            juce::MemoryBlock state;
+            source.getStateInformation(state);
+
+            // Truncated: not a complete state, so nothing changes
+            SimpleGainProcessor before;
+            copyValues(destination, before);
+            destination.setStateInformation(state.getData(), (int) state.getSize() - 2);
+            expectMatching(before, destination);
+
+            // A value that isn't finite goes back to its default
+            const auto nan = std::numeric_limits<float>::quiet_NaN();
+            std::memcpy(static_cast<char*>(state.getData()) + BinaryState::getSize(0), &nan, sizeof(nan));
+            destination.setStateInformation(state.getData(), (int) state.getSize());
+
+            auto* gain = getParameters(destination)[0];
+            expectEquals(gain->getValue(), gain->getDefaultValue());
+        }
+
+        beginTest("Preset banks round-trip through a file");
+        {
+            juce::TemporaryFile file(".sgbank");
+            auto presets = PresetBank::getBuiltInPresets();
+            presets[1].name = juce::String::repeatedString("Long name ", 40);
+            presets[2].values[0] = -17.5f;
+
+            expect(PresetBank::writeToFile(file.getFile(), presets));
+
+            PresetBank bank(file.getFile());
+            expect(bank.isFromFile());
+            expectEquals(bank.getNumPresets(), (int) presets.size());
+            expect(bank.getName(1).getNumBytesAsUTF8() <= 255);
+            expectEquals(bank.getValues(2)[0], -17.5f);
+
+            for (int i = 0; i < bank.getNumPresets(); ++i)
+                for (int v = 0; v < PresetBank::numValues; ++v)
+                    expectEquals(bank.getValues(i)[v], presets[(size_t) i].values[(size_t) v]);
+        }
+
+        beginTest("Unreadable bank files fall back to the built-in presets");
+        {
+            juce::TemporaryFile file(".sgbank");
+            expect(file.getFile().replaceWithText("not a preset bank"));
+
+            PresetBank bank(file.getFile());
+            expect(! bank.isFromFile());
+            expectEquals(bank.getNumPresets(), (int) PresetBank::getBuiltInPresets().size());
+        }
+    }
+
+private:
+    static juce::Array<juce::RangedAudioParameter*> getParameters(SimpleGainProcessor& processor)
+    {
+        juce::Array<juce::RangedAudioParameter*> parameters;
+
+        for (auto* parameter : processor.AudioProcessor::getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+                parameters.add(ranged);
+
+        return parameters;
+    }
+
+    // Values on each parameter's own grid, so the stored plain value maps back exactly
+    void randomise(SimpleGainProcessor& processor)
+    {
+        for (auto* parameter : getParameters(processor))
+        {
+            const auto plain = parameter->convertFrom0to1(getRandom().nextFloat());
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(plain));
+        }
+    }
+
+    static void copyValues(SimpleGainProcessor& source, SimpleGainProcessor& destination)
+    {
+        auto sourceParameters = getParameters(source);
+        auto destinationParameters = getParameters(destination);
+
+        for (int i = 0; i < sourceParameters.size(); ++i)
+            destinationParameters[i]->setValueNotifyingHost(sourceParameters[i]->getValue());
+    }
+
+    void expectMatching(SimpleGainProcessor& expected, SimpleGainProcessor& actual)
+    {
+        auto expectedParameters = getParameters(expected);
+        auto actualParameters = getParameters(actual);
+        expectEquals(actualParameters.size(), expectedParameters.size());
+
+        for (int i = 0; i < juce::jmin(expectedParameters.size(), actualParameters.size()); ++i)
+        {
+            auto* parameter = expectedParameters[i];
+            expectWithinAbsoluteError(actualParameters[i]->convertFrom0to1(actualParameters[i]->getValue()),
+                                      parameter->convertFrom0to1(parameter->getValue()),
+                                      1.0e-4f * (parameter->getNormalisableRange().end - parameter->getNormalisableRange().start),
+                                      parameter->getName(32));
+        }
+    }
+};
+
+static StateTests stateTests;
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "PluginProcessor.h"
+#include <type_traits>
+
+//==============================================================================
+/**
+ * Small helpers shared by the test files: building processors the way a host
+ * would, filling buffers and comparing them.
+ */
+namespace TestUtilities
+{
+    inline juce::AudioProcessor::BusesLayout makeLayout(int numChannels)
+    {
+        juce::AudioProcessor::BusesLayout layout;
+
+        // The same layouts the bench uses for the wide buses
+        const auto set = numChannels == 12 ? juce::AudioChannelSet::create7point1point4()
+                       : numChannels == 16 ? juce::AudioChannelSet::ambisonic(3)
+                                           : juce::AudioChannelSet::canonicalChannelSet(numChannels);
+        layout.inputBuses.add(set);
+        layout.outputBuses.add(set);
+        return layout;
+    }
+
+    inline void setParameter(SimpleGainProcessor& processor, const juce::String& parameterID, float value)
+    {
+        if (auto* parameter = processor.getParameters().getParameter(parameterID))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    // The value the processor actually received, after the parameter snapped it to its interval
+    inline float getParameter(SimpleGainProcessor& processor, const juce::String& parameterID)
+    {
+        return processor.getParameters().getRawParameterValue(parameterID)->load();
+    }
+
+    // Prepared as an offline render; tests of the real-time path switch that off afterwards
+    template <typename SampleType>
+    bool prepare(SimpleGainProcessor& processor, int numChannels, double sampleRate, int maxBlockSize)
+    {
+        if (! processor.setBusesLayout(makeLayout(numChannels)))
+            return false;
+
+        processor.setProcessingPrecision(std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                             : juce::AudioProcessor::singlePrecision);
+        processor.setNonRealtime(true);
+        processor.setRateAndBufferSizeDetails(sampleRate, maxBlockSize);
+        processor.prepareToPlay(sampleRate, maxBlockSize);
+        return true;
+    }
+
+    template <typename SampleType>
+    void fillWithNoise(juce::AudioBuffer<SampleType>& buffer, juce::Random& random, float level = 1.0f)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+                buffer.setSample(channel, sample, (SampleType) (level * (random.nextFloat() * 2.0f - 1.0f)));
+    }
+
+    // Runs the whole buffer through processBlock in blocks of the given sizes, cycling through them
+    template <typename SampleType, typename BeforeBlock>
+    void processInBlocks(SimpleGainProcessor& processor, juce::AudioBuffer<SampleType>& buffer,
+                         const juce::Array<int>& blockSizes, BeforeBlock&& beforeBlock)
+    {
+        juce::MidiBuffer midi;
+        int blockIndex = 0;
+
+        for (int start = 0; start < buffer.getNumSamples(); ++blockIndex)
+        {
+            const auto size = juce::jmin(blockSizes[blockIndex % blockSizes.size()], buffer.getNumSamples() - start);
+            juce::AudioBuffer<SampleType> view(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, size);
+
+            beforeBlock(blockIndex, start, size);
+            processor.processBlock(view, midi);
+            start += size;
+        }
+    }
+
+    template <typename SampleType>
+    void processInBlocks(SimpleGainProcessor& processor, juce::AudioBuffer<SampleType>& buffer, int blockSize)
+    {
+        processInBlocks(processor, buffer, { blockSize }, [](int, int, int) {});
+    }
+
+    // Largest absolute difference over every channel, from startSample on
+    template <typename SampleType>
+    double maxDifference(const juce::AudioBuffer<SampleType>& a, const juce::AudioBuffer<SampleType>& b, int startSample = 0)
+    {
+        double difference = 0.0;
+
+        for (int channel = 0; channel < juce::jmin(a.getNumChannels(), b.getNumChannels()); ++channel)
+            for (int sample = startSample; sample < juce::jmin(a.getNumSamples(), b.getNumSamples()); ++sample)
+                difference = juce::jmax(difference, std::abs((double) a.getSample(channel, sample)
+                                                             - (double) b.getSample(channel, sample)));
+
+        return difference;
+    }
+}